@@ -0,0 +1,250 @@
+#include "colorindex.h"
+
+// std includes
+#include <algorithm>
+
+// Qt includes
+#include <QFutureWatcher>
+#include <QTextBlock>
+#include <QTextCursor>
+#include <QTextDocument>
+#include <QTimer>
+#include <QtConcurrentRun>
+
+// Plugin includes
+#include "colorscanner.h"
+
+namespace {
+
+using namespace ColorPicker::Internal;
+
+// Above this number of touched blocks, an edit triggers a full rebuild on the
+// worker thread instead of an incremental update
+const int MAX_INCREMENTAL_BLOCK_COUNT = 64;
+
+const int REBUILD_DELAY = 200; // ms
+
+// Indexes the lines of text, each one on its own as the editor does
+ColorIndexEntries indexText(const QString &text, const ColorScanner &scanner, int offset)
+{
+    ColorIndexEntries ret;
+
+    const int size = text.size();
+    int lineStart = 0;
+
+    while (lineStart <= size) {
+        int lineEnd = text.indexOf(QLatin1Char('\n'), lineStart);
+        if (lineEnd < 0)
+            lineEnd = size;
+
+        const ColorMatchList matches = scanner.scan(text, lineStart, lineEnd);
+
+        for (const ColorMatch &match : matches) {
+            ColorIndexEntry entry;
+            entry.offset = offset + match.start;
+            entry.length = match.length;
+            entry.format = match.format;
+            entry.value = parseColor(text, match);
+
+            ret.append(entry);
+        }
+
+        lineStart = lineEnd + 1;
+    }
+
+    return ret;
+}
+
+bool entryIsBefore(const ColorIndexEntry &entry, int offset)
+{
+    return entry.offset < offset;
+}
+
+} // anon namespace
+
+namespace ColorPicker {
+namespace Internal {
+
+
+////////////////////////// ColorIndexImpl //////////////////////////
+
+class ColorIndexImpl
+{
+public:
+    ColorIndexImpl(ColorIndex *qq, QTextDocument *doc);
+
+    /* functions */
+    void scheduleRebuild();
+    void startRebuild();
+    void onRebuildFinished();
+
+    void onContentsChange(int position, int charsRemoved, int charsAdded);
+
+    /* variables */
+    ColorIndex *q;
+
+    QTextDocument *document;
+    ColorScanner scanner;
+
+    ColorIndexEntries entries;
+    bool ready;
+
+    int snapshotRevision;
+    QFutureWatcher<ColorIndexEntries> rebuildWatcher;
+    QTimer rebuildTimer;
+};
+
+ColorIndexImpl::ColorIndexImpl(ColorIndex *qq, QTextDocument *doc) :
+    q(qq),
+    document(doc),
+    scanner(),
+    entries(),
+    ready(false),
+    snapshotRevision(-1),
+    rebuildWatcher(),
+    rebuildTimer()
+{}
+
+void ColorIndexImpl::scheduleRebuild()
+{
+    ready = false;
+
+    rebuildTimer.start();
+}
+
+void ColorIndexImpl::startRebuild()
+{
+    // A running build is simply outdated, its result gets discarded
+    if (rebuildWatcher.isRunning()) {
+        rebuildTimer.start();
+        return;
+    }
+
+    snapshotRevision = document->revision();
+
+    const QString snapshot = document->toPlainText();
+    const ColorScanner scannerCopy = scanner;
+
+    rebuildWatcher.setFuture(QtConcurrent::run([snapshot, scannerCopy]() {
+        return indexText(snapshot, scannerCopy, 0);
+    }));
+}
+
+void ColorIndexImpl::onRebuildFinished()
+{
+    if (rebuildTimer.isActive() || document->revision() != snapshotRevision) {
+        scheduleRebuild();
+        return;
+    }
+
+    entries = rebuildWatcher.result();
+    ready = true;
+
+    emit q->indexChanged();
+}
+
+void ColorIndexImpl::onContentsChange(int position, int charsRemoved, int charsAdded)
+{
+    if (!ready) {
+        scheduleRebuild();
+        return;
+    }
+
+    // Lines [firstBlock, lastBlock] have to be indexed again
+    const QTextBlock firstBlock = document->findBlock(position);
+    const QTextBlock lastBlock = document->findBlock(position + charsAdded);
+
+    if (!firstBlock.isValid() || !lastBlock.isValid()
+            || lastBlock.blockNumber() - firstBlock.blockNumber() > MAX_INCREMENTAL_BLOCK_COUNT) {
+        scheduleRebuild();
+        return;
+    }
+
+    const int delta = charsAdded - charsRemoved;
+    const int rangeStart = firstBlock.position();
+    const int newRangeEnd = lastBlock.position() + lastBlock.length();
+    const int oldRangeEnd = newRangeEnd - delta;
+
+    auto first = std::lower_bound(entries.begin(), entries.end(), rangeStart, entryIsBefore);
+    auto last = std::lower_bound(first, entries.end(), oldRangeEnd, entryIsBefore);
+
+    // Shift what follows the change
+    for (auto it = last; it != entries.end(); ++it)
+        it->offset += delta;
+
+    // Replace the entries of the touched lines
+    QTextCursor rangeCursor(document);
+    rangeCursor.setPosition(rangeStart);
+    rangeCursor.setPosition(newRangeEnd - 1, QTextCursor::KeepAnchor);
+
+    QString rangeText = rangeCursor.selectedText();
+    rangeText.replace(QChar::ParagraphSeparator, QLatin1Char('\n'));
+
+    const ColorIndexEntries newEntries = indexText(rangeText, scanner, rangeStart);
+
+    const int firstIndex = int(first - entries.begin());
+    entries.erase(first, last);
+
+    for (int i = 0; i < newEntries.size(); ++i)
+        entries.insert(firstIndex + i, newEntries.at(i));
+
+    emit q->indexChanged();
+}
+
+
+////////////////////////// ColorIndex //////////////////////////
+
+ColorIndex::ColorIndex(QTextDocument *document, const ColorFormatSet &formats,
+                       QObject *parent) :
+    QObject(parent),
+    d(new ColorIndexImpl(this, document))
+{
+    Q_ASSERT(document);
+
+    d->scanner.setFormats(formats);
+
+    d->rebuildTimer.setSingleShot(true);
+    d->rebuildTimer.setInterval(REBUILD_DELAY);
+
+    connect(&d->rebuildTimer, &QTimer::timeout,
+            this, [=]() { d->startRebuild(); });
+
+    connect(&d->rebuildWatcher, &QFutureWatcher<ColorIndexEntries>::finished,
+            this, [=]() { d->onRebuildFinished(); });
+
+    connect(document, &QTextDocument::contentsChange,
+            this, [=](int position, int charsRemoved, int charsAdded) {
+        d->onContentsChange(position, charsRemoved, charsAdded);
+    });
+
+    d->startRebuild();
+}
+
+ColorIndex::~ColorIndex()
+{}
+
+ColorFormatSet ColorIndex::formats() const
+{
+    return d->scanner.formats();
+}
+
+void ColorIndex::setFormats(const ColorFormatSet &formats)
+{
+    if (d->scanner.formats() != formats) {
+        d->scanner.setFormats(formats);
+        d->scheduleRebuild();
+    }
+}
+
+bool ColorIndex::isReady() const
+{
+    return d->ready;
+}
+
+ColorIndexEntries ColorIndex::entries() const
+{
+    return d->entries;
+}
+
+} // namespace Internal
+} // namespace ColorPicker
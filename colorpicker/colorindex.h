@@ -0,0 +1,55 @@
+#ifndef COLORINDEX_H
+#define COLORINDEX_H
+
+#include <QObject>
+
+#include "colorutilities.h"
+
+class QTextDocument;
+
+namespace ColorPicker {
+namespace Internal {
+
+class ColorIndexImpl;
+
+struct ColorIndexEntry
+{
+    int end() const { return offset + length; }
+
+    int offset;                 // Position in the document
+    int length;
+    ColorFormat format;
+    QColor value;
+};
+
+typedef QVector<ColorIndexEntry> ColorIndexEntries;
+
+// Every color expression of a document, sorted by offset. The index is built
+// on a worker thread from a snapshot of the document, then kept up to date
+// from the contentsChange() deltas.
+class ColorIndex : public QObject
+{
+    Q_OBJECT
+
+public:
+    ColorIndex(QTextDocument *document, const ColorFormatSet &formats,
+               QObject *parent = nullptr);
+    ~ColorIndex();
+
+    ColorFormatSet formats() const;
+    void setFormats(const ColorFormatSet &formats);
+
+    bool isReady() const;
+    ColorIndexEntries entries() const;
+
+signals:
+    void indexChanged();
+
+private:
+    QScopedPointer<ColorIndexImpl> d;
+};
+
+} // namespace Internal
+} // namespace ColorPicker
+
+#endif // COLORINDEX_H
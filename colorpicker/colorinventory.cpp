@@ -0,0 +1,634 @@
+#include "colorinventory.h"
+
+// std includes
+#include <algorithm>
+
+// Qt includes
+#include <QFile>
+#include <QFileInfo>
+#include <QMap>
+#include <QSaveFile>
+
+namespace {
+
+using namespace ColorPicker::Internal;
+
+// Index file layout, in native byte order :
+//   IndexHeader
+//   FileRecord[fileCount], sorted by name
+//   OccurrenceRecord[occurrenceCount], grouped by file
+//   ColorRecord[colorCount], sorted by QRgb
+//   quint32[occurrenceCount], indexes of the occurrences grouped by color
+//   file names, UTF-16
+const quint32 INDEX_MAGIC = 0x58495043; // "CPIX"
+const quint32 INDEX_VERSION = 3; // 2 : named colors, 3 : queried in place
+
+struct IndexHeader
+{
+    quint32 magic;
+    quint32 version;
+    quint32 fileCount;
+    quint32 occurrenceCount;
+    quint32 colorCount;
+    quint32 namesLength;        // In UTF-16 code units
+};
+
+struct FileRecord
+{
+    qint64 modified;
+    qint64 size;
+    quint64 hash;
+    quint32 nameOffset;
+    quint32 nameLength;
+    quint32 firstOccurrence;
+    quint32 occurrenceCount;
+};
+
+struct OccurrenceRecord
+{
+    quint64 rgba64;
+    quint32 line;
+    quint32 column;
+    quint32 offset;
+    quint32 length;
+    quint32 format;
+    quint32 fileIndex;
+};
+
+struct ColorRecord
+{
+    quint32 rgba;
+    quint32 firstReference;
+    quint32 referenceCount;
+    quint32 reserved;
+};
+
+// Every record stays 8 bytes aligned in the mapped file
+static_assert(sizeof(IndexHeader) % 8 == 0, "IndexHeader must keep records aligned");
+static_assert(sizeof(FileRecord) % 8 == 0, "FileRecord must keep records aligned");
+static_assert(sizeof(OccurrenceRecord) % 8 == 0, "OccurrenceRecord must keep records aligned");
+static_assert(sizeof(ColorRecord) % 8 == 0, "ColorRecord must keep records aligned");
+
+const IndexHeader *headerOf(const uchar *data)
+{
+    return reinterpret_cast<const IndexHeader *>(data);
+}
+
+const FileRecord *fileRecordsOf(const uchar *data)
+{
+    return reinterpret_cast<const FileRecord *>(data + sizeof(IndexHeader));
+}
+
+const OccurrenceRecord *occurrenceRecordsOf(const uchar *data)
+{
+    return reinterpret_cast<const OccurrenceRecord *>(fileRecordsOf(data)
+                                                      + headerOf(data)->fileCount);
+}
+
+const ColorRecord *colorRecordsOf(const uchar *data)
+{
+    return reinterpret_cast<const ColorRecord *>(occurrenceRecordsOf(data)
+                                                 + headerOf(data)->occurrenceCount);
+}
+
+const quint32 *colorReferencesOf(const uchar *data)
+{
+    return reinterpret_cast<const quint32 *>(colorRecordsOf(data) + headerOf(data)->colorCount);
+}
+
+const QChar *namesOf(const uchar *data)
+{
+    return reinterpret_cast<const QChar *>(colorReferencesOf(data)
+                                           + headerOf(data)->occurrenceCount);
+}
+
+// Valid as long as the file stays mapped
+QString mappedName(const uchar *data, const FileRecord &record)
+{
+    return QString::fromRawData(namesOf(data) + record.nameOffset, int(record.nameLength));
+}
+
+qint64 indexSize(const IndexHeader &header)
+{
+    return qint64(sizeof(IndexHeader))
+            + qint64(header.fileCount) * qint64(sizeof(FileRecord))
+            + qint64(header.occurrenceCount) * qint64(sizeof(OccurrenceRecord))
+            + qint64(header.colorCount) * qint64(sizeof(ColorRecord))
+            + qint64(header.occurrenceCount) * qint64(sizeof(quint32))
+            + qint64(header.namesLength) * qint64(sizeof(QChar));
+}
+
+// Checks the bounds of every record once, so that the queries can trust them
+bool isIndexValid(const uchar *data)
+{
+    const IndexHeader &header = *headerOf(data);
+
+    const FileRecord *fileRecords = fileRecordsOf(data);
+
+    for (quint32 i = 0; i < header.fileCount; ++i) {
+        const FileRecord &record = fileRecords[i];
+
+        if (quint64(record.nameOffset) + record.nameLength > header.namesLength
+                || quint64(record.firstOccurrence) + record.occurrenceCount
+                   > header.occurrenceCount) {
+            return false;
+        }
+    }
+
+    const OccurrenceRecord *occurrenceRecords = occurrenceRecordsOf(data);
+
+    for (quint32 i = 0; i < header.occurrenceCount; ++i) {
+        const OccurrenceRecord &record = occurrenceRecords[i];
+
+        if (record.format >= COLOR_FORMAT_COUNT || record.fileIndex >= header.fileCount)
+            return false;
+    }
+
+    const ColorRecord *colorRecords = colorRecordsOf(data);
+    const quint32 *references = colorReferencesOf(data);
+
+    for (quint32 i = 0; i < header.colorCount; ++i) {
+        const ColorRecord &record = colorRecords[i];
+
+        if (quint64(record.firstReference) + record.referenceCount > header.occurrenceCount)
+            return false;
+    }
+
+    for (quint32 i = 0; i < header.occurrenceCount; ++i) {
+        if (references[i] >= header.occurrenceCount)
+            return false;
+    }
+
+    return true;
+}
+
+OccurrenceRecord toRecord(const ColorOccurrence &occurrence, quint32 fileIndex)
+{
+    OccurrenceRecord ret;
+    ret.rgba64 = occurrence.value.rgba64();
+    ret.line = quint32(occurrence.line);
+    ret.column = quint32(occurrence.column);
+    ret.offset = quint32(occurrence.offset);
+    ret.length = quint32(occurrence.length);
+    ret.format = quint32(occurrence.format);
+    ret.fileIndex = fileIndex;
+
+    return ret;
+}
+
+} // anon namespace
+
+namespace ColorPicker {
+namespace Internal {
+
+ColorInventory::ColorInventory() :
+    m_indexFile(),
+    m_mapped(nullptr),
+    m_removedFiles(),
+    m_files(),
+    m_stamps(),
+    m_colors(),
+    m_occurrenceCount(0)
+{}
+
+void ColorInventory::clear()
+{
+    m_indexFile.clear();
+    m_mapped = nullptr;
+    m_removedFiles.clear();
+
+    m_files.clear();
+    m_stamps.clear();
+    m_colors.clear();
+    m_occurrenceCount = 0;
+}
+
+void ColorInventory::addFile(const FileColors &file)
+{
+    removeFile(file.fileName);
+
+    m_files.insert(file.fileName, file.occurrences);
+    m_stamps.insert(file.fileName, file.stamp);
+
+    for (const ColorOccurrence &occurrence : file.occurrences)
+        m_colors[occurrence.value.rgba()].append(occurrence);
+
+    m_occurrenceCount += file.occurrences.size();
+}
+
+void ColorInventory::removeFile(const QString &fileName)
+{
+    quint32 mappedIndex = 0;
+
+    if (findMappedFile(fileName, &mappedIndex))
+        removeMappedFile(mappedIndex);
+
+    m_stamps.remove(fileName);
+
+    auto fileIt = m_files.find(fileName);
+    if (fileIt == m_files.end())
+        return;
+
+    const ColorOccurrences removed = fileIt.value();
+    m_files.erase(fileIt);
+
+    for (const ColorOccurrence &occurrence : removed) {
+        auto it = m_colors.find(occurrence.value.rgba());
+        if (it == m_colors.end())
+            continue;
+
+        ColorOccurrences &occurrences = it.value();
+
+        for (int i = occurrences.size() - 1; i >= 0; --i) {
+            if (occurrences.at(i).fileName == fileName)
+                occurrences.remove(i);
+        }
+
+        if (occurrences.isEmpty())
+            m_colors.erase(it);
+    }
+
+    m_occurrenceCount -= removed.size();
+}
+
+bool ColorInventory::contains(const QString &fileName) const
+{
+    quint32 mappedIndex = 0;
+
+    return m_files.contains(fileName) || findMappedFile(fileName, &mappedIndex);
+}
+
+QStringList ColorInventory::fileNames() const
+{
+    QStringList ret = m_files.keys();
+
+    if (!m_mapped)
+        return ret;
+
+    const FileRecord *fileRecords = fileRecordsOf(m_mapped);
+
+    for (quint32 i = 0; i < headerOf(m_mapped)->fileCount; ++i) {
+        if (!m_removedFiles.contains(i))
+            ret.append(QString(namesOf(m_mapped) + fileRecords[i].nameOffset,
+                               int(fileRecords[i].nameLength)));
+    }
+
+    return ret;
+}
+
+FileColors ColorInventory::file(const QString &fileName) const
+{
+    FileColors ret;
+    ret.fileName = fileName;
+    ret.stamp = FileStamp();
+    ret.unchanged = false;
+
+    stamp(fileName, &ret.stamp);
+
+    quint32 mappedIndex = 0;
+
+    if (m_files.contains(fileName)) {
+        ret.occurrences = m_files.value(fileName);
+    }
+    else if (findMappedFile(fileName, &mappedIndex)) {
+        const FileRecord &record = fileRecordsOf(m_mapped)[mappedIndex];
+
+        for (quint32 i = 0; i < record.occurrenceCount; ++i)
+            ret.occurrences.append(mappedOccurrence(record.firstOccurrence + i));
+    }
+
+    return ret;
+}
+
+bool ColorInventory::stamp(const QString &fileName, FileStamp *stamp) const
+{
+    Q_ASSERT(stamp);
+
+    auto it = m_stamps.constFind(fileName);
+
+    if (it != m_stamps.cend()) {
+        *stamp = it.value();
+        return true;
+    }
+
+    quint32 mappedIndex = 0;
+
+    if (!findMappedFile(fileName, &mappedIndex))
+        return false;
+
+    const FileRecord &record = fileRecordsOf(m_mapped)[mappedIndex];
+
+    stamp->modified = record.modified;
+    stamp->size = record.size;
+    stamp->hash = record.hash;
+
+    return true;
+}
+
+void ColorInventory::setStamp(const QString &fileName, const FileStamp &stamp)
+{
+    if (contains(fileName))
+        m_stamps.insert(fileName, stamp);
+}
+
+QList<QRgb> ColorInventory::colors() const
+{
+    QList<QRgb> ret = m_colors.keys();
+
+    if (!m_mapped)
+        return ret;
+
+    const ColorRecord *colorRecords = colorRecordsOf(m_mapped);
+    const quint32 *references = colorReferencesOf(m_mapped);
+    const OccurrenceRecord *occurrenceRecords = occurrenceRecordsOf(m_mapped);
+
+    for (quint32 i = 0; i < headerOf(m_mapped)->colorCount; ++i) {
+        const ColorRecord &record = colorRecords[i];
+
+        if (m_colors.contains(record.rgba))
+            continue;
+
+        // Still used by a file that was not removed
+        for (quint32 j = 0; j < record.referenceCount; ++j) {
+            const quint32 occurrence = references[record.firstReference + j];
+
+            if (!m_removedFiles.contains(occurrenceRecords[occurrence].fileIndex)) {
+                ret.append(record.rgba);
+                break;
+            }
+        }
+    }
+
+    return ret;
+}
+
+ColorOccurrences ColorInventory::occurrences(QRgb color) const
+{
+    ColorOccurrences ret;
+
+    if (m_mapped) {
+        const ColorRecord *first = colorRecordsOf(m_mapped);
+        const ColorRecord *last = first + headerOf(m_mapped)->colorCount;
+
+        auto it = std::lower_bound(first, last, color,
+                                   [](const ColorRecord &record, QRgb rgba) {
+            return record.rgba < rgba;
+        });
+
+        if (it != last && it->rgba == color) {
+            const quint32 *references = colorReferencesOf(m_mapped);
+            const OccurrenceRecord *occurrenceRecords = occurrenceRecordsOf(m_mapped);
+
+            for (quint32 j = 0; j < it->referenceCount; ++j) {
+                const quint32 occurrence = references[it->firstReference + j];
+
+                if (!m_removedFiles.contains(occurrenceRecords[occurrence].fileIndex))
+                    ret.append(mappedOccurrence(occurrence));
+            }
+        }
+    }
+
+    ret += m_colors.value(color);
+
+    return ret;
+}
+
+int ColorInventory::fileCount() const
+{
+    int ret = m_files.size();
+
+    if (m_mapped)
+        ret += int(headerOf(m_mapped)->fileCount) - m_removedFiles.size();
+
+    return ret;
+}
+
+int ColorInventory::occurrenceCount() const
+{
+    return m_occurrenceCount;
+}
+
+bool ColorInventory::load(const QString &indexFileName)
+{
+    clear();
+
+    QSharedPointer<QFile> file(new QFile(indexFileName));
+
+    if (!file->open(QIODevice::ReadOnly) || file->size() < qint64(sizeof(IndexHeader)))
+        return false;
+
+    const uchar *data = file->map(0, file->size());
+    if (!data)
+        return false;
+
+    const IndexHeader *header = headerOf(data);
+
+    if (header->magic != INDEX_MAGIC || header->version != INDEX_VERSION
+            || indexSize(*header) != file->size() || !isIndexValid(data)) {
+        return false;
+    }
+
+    // Unmapped when the last copy goes away
+    m_indexFile = file;
+    m_mapped = data;
+    m_occurrenceCount = int(header->occurrenceCount);
+
+    return true;
+}
+
+bool ColorInventory::save(const QString &indexFileName)
+{
+    QStringList names = fileNames();
+    std::sort(names.begin(), names.end());
+
+    QVector<FileRecord> fileRecords;
+    fileRecords.reserve(names.size());
+
+    QVector<OccurrenceRecord> occurrenceRecords;
+    occurrenceRecords.reserve(m_occurrenceCount);
+
+    QString namesData;
+
+    for (const QString &name : names) {
+        const quint32 fileIndex = quint32(fileRecords.size());
+
+        FileStamp fileStamp = FileStamp();
+        stamp(name, &fileStamp);
+
+        FileRecord fileRecord;
+        fileRecord.modified = fileStamp.modified;
+        fileRecord.size = fileStamp.size;
+        fileRecord.hash = fileStamp.hash;
+        fileRecord.nameOffset = quint32(namesData.size());
+        fileRecord.nameLength = quint32(name.size());
+        fileRecord.firstOccurrence = quint32(occurrenceRecords.size());
+
+        quint32 mappedIndex = 0;
+
+        if (m_files.contains(name)) {
+            for (const ColorOccurrence &occurrence : m_files.value(name))
+                occurrenceRecords.append(toRecord(occurrence, fileIndex));
+        }
+        else if (findMappedFile(name, &mappedIndex)) {
+            const FileRecord &mappedRecord = fileRecordsOf(m_mapped)[mappedIndex];
+
+            for (quint32 i = 0; i < mappedRecord.occurrenceCount; ++i) {
+                OccurrenceRecord record =
+                        occurrenceRecordsOf(m_mapped)[mappedRecord.firstOccurrence + i];
+                record.fileIndex = fileIndex;
+
+                occurrenceRecords.append(record);
+            }
+        }
+
+        fileRecord.occurrenceCount = quint32(occurrenceRecords.size()) - fileRecord.firstOccurrence;
+
+        fileRecords.append(fileRecord);
+        namesData.append(name);
+    }
+
+    // Sorted by QRgb, the occurrences of each color keeping the file order
+    QMap<QRgb, QVector<quint32>> colorGroups;
+
+    for (int i = 0; i < occurrenceRecords.size(); ++i) {
+        const QRgb rgba = QRgba64::fromRgba64(occurrenceRecords.at(i).rgba64).toArgb32();
+        colorGroups[rgba].append(quint32(i));
+    }
+
+    QVector<ColorRecord> colorRecords;
+    colorRecords.reserve(colorGroups.size());
+
+    QVector<quint32> references;
+    references.reserve(occurrenceRecords.size());
+
+    for (auto it = colorGroups.cbegin(); it != colorGroups.cend(); ++it) {
+        ColorRecord colorRecord;
+        colorRecord.rgba = it.key();
+        colorRecord.firstReference = quint32(references.size());
+        colorRecord.referenceCount = quint32(it.value().size());
+        colorRecord.reserved = 0;
+
+        colorRecords.append(colorRecord);
+        references += it.value();
+    }
+
+    IndexHeader header;
+    header.magic = INDEX_MAGIC;
+    header.version = INDEX_VERSION;
+    header.fileCount = quint32(fileRecords.size());
+    header.occurrenceCount = quint32(occurrenceRecords.size());
+    header.colorCount = quint32(colorRecords.size());
+    header.namesLength = quint32(namesData.size());
+
+    QSaveFile file(indexFileName);
+
+    if (!file.open(QIODevice::WriteOnly))
+        return false;
+
+    file.write(reinterpret_cast<const char *>(&header), sizeof(header));
+    file.write(reinterpret_cast<const char *>(fileRecords.constData()),
+               fileRecords.size() * qint64(sizeof(FileRecord)));
+    file.write(reinterpret_cast<const char *>(occurrenceRecords.constData()),
+               occurrenceRecords.size() * qint64(sizeof(OccurrenceRecord)));
+    file.write(reinterpret_cast<const char *>(colorRecords.constData()),
+               colorRecords.size() * qint64(sizeof(ColorRecord)));
+    file.write(reinterpret_cast<const char *>(references.constData()),
+               references.size() * qint64(sizeof(quint32)));
+    file.write(reinterpret_cast<const char *>(namesData.constData()),
+               namesData.size() * qint64(sizeof(QChar)));
+
+    // Some systems do not replace a file that is mapped : the records are
+    // copied above, the mapping can go. The files scanned since it was loaded
+    // are kept aside, a failed commit leaves the previous file and they go
+    // back on top of it.
+    const bool replacesMapping = m_indexFile
+            && QFileInfo(m_indexFile->fileName()) == QFileInfo(indexFileName);
+
+    const QString previousFileName = (m_indexFile) ? m_indexFile->fileName() : QString();
+
+    ColorInventory scanned;
+
+    if (replacesMapping) {
+        scanned = *this;
+        scanned.m_indexFile.clear();
+        scanned.m_mapped = nullptr;
+
+        clear();
+    }
+
+    if (!file.commit()) {
+        if (replacesMapping) {
+            if (load(previousFileName)) {
+                scanned.m_indexFile = m_indexFile;
+                scanned.m_mapped = m_mapped;
+            }
+            else {
+                // Only the scanned files are left
+                scanned.m_removedFiles.clear();
+                scanned.m_occurrenceCount = 0;
+
+                for (const ColorOccurrences &occurrences : scanned.m_files)
+                    scanned.m_occurrenceCount += occurrences.size();
+            }
+
+            *this = scanned;
+        }
+
+        return false;
+    }
+
+    // The saved records are queried in place from now on
+    if (replacesMapping)
+        load(indexFileName);
+
+    return true;
+}
+
+bool ColorInventory::findMappedFile(const QString &fileName, quint32 *index) const
+{
+    if (!m_mapped)
+        return false;
+
+    const FileRecord *first = fileRecordsOf(m_mapped);
+    const FileRecord *last = first + headerOf(m_mapped)->fileCount;
+
+    const uchar *data = m_mapped;
+
+    auto it = std::lower_bound(first, last, fileName,
+                               [data](const FileRecord &record, const QString &name) {
+        return mappedName(data, record) < name;
+    });
+
+    if (it == last || mappedName(data, *it) != fileName)
+        return false;
+
+    *index = quint32(it - first);
+
+    return !m_removedFiles.contains(*index);
+}
+
+void ColorInventory::removeMappedFile(quint32 index)
+{
+    m_removedFiles.insert(index);
+    m_occurrenceCount -= int(fileRecordsOf(m_mapped)[index].occurrenceCount);
+}
+
+ColorOccurrence ColorInventory::mappedOccurrence(quint32 index) const
+{
+    const OccurrenceRecord &record = occurrenceRecordsOf(m_mapped)[index];
+    const FileRecord &fileRecord = fileRecordsOf(m_mapped)[record.fileIndex];
+
+    ColorOccurrence ret;
+    ret.fileName = QString(namesOf(m_mapped) + fileRecord.nameOffset, int(fileRecord.nameLength));
+    ret.line = int(record.line);
+    ret.column = int(record.column);
+    ret.offset = int(record.offset);
+    ret.length = int(record.length);
+    ret.format = ColorFormat(record.format);
+    ret.value = QColor::fromRgba64(QRgba64::fromRgba64(record.rgba64));
+
+    return ret;
+}
+
+} // namespace Internal
+} // namespace ColorPicker
@@ -0,0 +1,96 @@
+#ifndef COLORINVENTORY_H
+#define COLORINVENTORY_H
+
+#include <QHash>
+#include <QSet>
+#include <QSharedPointer>
+#include <QString>
+#include <QStringList>
+
+#include "colorutilities.h"
+
+class QFile;
+
+namespace ColorPicker {
+namespace Internal {
+
+struct ColorOccurrence
+{
+    QString fileName;
+    int line;                   // 1-based
+    int column;                 // In bytes
+    int offset;                 // In bytes
+    int length;
+    ColorFormat format;
+    QColor value;
+};
+
+typedef QVector<ColorOccurrence> ColorOccurrences;
+
+// Identifies the contents a file had when it was scanned
+struct FileStamp
+{
+    qint64 modified;            // Last modification, in ms since epoch
+    qint64 size;
+    quint64 hash;               // FNV-1a of the contents
+};
+
+struct FileColors
+{
+    QString fileName;
+    FileStamp stamp;
+    bool unchanged;             // Whether the previous occurrences still apply
+    ColorOccurrences occurrences;
+};
+
+// Every color used by a set of files, grouped by value. A loaded index file is
+// queried where it is mapped in memory, the files scanned since then are kept
+// aside and replace their mapped records. Copies share the mapping.
+class ColorInventory
+{
+public:
+    ColorInventory();
+
+    void clear();
+
+    void addFile(const FileColors &file);
+    void removeFile(const QString &fileName);
+
+    bool contains(const QString &fileName) const;
+    QStringList fileNames() const;
+    FileColors file(const QString &fileName) const;
+
+    bool stamp(const QString &fileName, FileStamp *stamp) const;
+    void setStamp(const QString &fileName, const FileStamp &stamp);
+
+    QList<QRgb> colors() const;
+    ColorOccurrences occurrences(QRgb color) const;
+
+    int fileCount() const;
+    int occurrenceCount() const;
+
+    // Binary index file, mapped in memory when read back. The files are stored
+    // with their stamp so that only the modified ones have to be scanned again.
+    // Saving folds the scanned files into the file, which is then mapped.
+    bool load(const QString &indexFileName);
+    bool save(const QString &indexFileName);
+
+private:
+    bool findMappedFile(const QString &fileName, quint32 *index) const;
+    void removeMappedFile(quint32 index);
+    ColorOccurrence mappedOccurrence(quint32 index) const;
+
+    QSharedPointer<QFile> m_indexFile;
+    const uchar *m_mapped;                      // Null without index file
+    QSet<quint32> m_removedFiles;               // Mapped files removed or scanned again
+
+    QHash<QString, ColorOccurrences> m_files;   // Scanned since the index was loaded
+    QHash<QString, FileStamp> m_stamps;         // Their stamps, and the updated mapped ones
+    QHash<QRgb, ColorOccurrences> m_colors;
+    int m_occurrenceCount;
+};
+
+} // namespace Internal
+} // namespace ColorPicker
+
+#endif // COLORINVENTORY_H
@@ -1,18 +1,83 @@
 #include "colormodifier.h"
 
+// std includes
+#include <algorithm>
+
 // Qt includes
 #include <QDebug>
+#include <QPointer>
 #include <QTextBlock>
 #include <QTextCursor>
+#include <QTextDocument>
+#include <QTimer>
 
 // QtCreator includes
 #include <coreplugin/editormanager/editormanager.h>
 
 #include <texteditor/texteditor.h>
 
+// Plugin includes
+#include "colorindex.h"
+#include "colortrace.h"
+
+#include "widgets/colorpreviewoverlay.h"
+
 using namespace Core;
 using namespace TextEditor;
 
+namespace {
+
+// ms, a frame of a 60 Hz display
+const int FRAME_INTERVAL = 16;
+
+TextEditorWidget *currentEditorWidget()
+{
+    IEditor *currentEditor = EditorManager::instance()->currentEditor();
+    if (!currentEditor)
+        return nullptr;
+
+    return qobject_cast<TextEditorWidget *>(currentEditor->widget());
+}
+
+// Only rewrites the characters between the common prefix and the common suffix
+// of the selected text and newText, e.g. "1" of "rgb(12, 21, 40)" replacing
+// "rgb(12, 20, 40)", which keeps the layout and highlighting work small.
+// newText is then selected, in the direction of the previous selection.
+void replaceSelection(QTextCursor &cursor, const QString &newText)
+{
+    const QString oldText = cursor.selectedText();
+    const int start = cursor.selectionStart();
+    const bool anchorAtEnd = (cursor.anchor() > cursor.position());
+
+    const int commonMax = qMin(oldText.size(), newText.size());
+
+    int prefix = 0;
+    while (prefix < commonMax && oldText.at(prefix) == newText.at(prefix))
+        ++prefix;
+
+    int suffix = 0;
+    while (suffix < commonMax - prefix
+           && oldText.at(oldText.size() - 1 - suffix) == newText.at(newText.size() - 1 - suffix))
+        ++suffix;
+
+    cursor.setPosition(start + prefix);
+    cursor.setPosition(start + oldText.size() - suffix, QTextCursor::KeepAnchor);
+
+    const QString changedText = newText.mid(prefix, newText.size() - prefix - suffix);
+
+    if (changedText.isEmpty())
+        cursor.removeSelectedText();
+    else
+        cursor.insertText(changedText);
+
+    const int end = start + newText.size();
+
+    cursor.setPosition(anchorAtEnd ? end : start);
+    cursor.setPosition(anchorAtEnd ? start : end, QTextCursor::KeepAnchor);
+}
+
+} // anon namespace
+
 namespace ColorPicker {
 namespace Internal {
 
@@ -22,13 +87,254 @@ namespace Internal {
 class ColorModifierImpl
 {
 public:
+    struct PinnedRange
+    {
+        QTextCursor cursor;     // Selects the expression, follows the edits
+        ColorFormat format;     // Used instead of the written one if keepFormats
+    };
+
+    // Expressions of a document, written together
+    struct Expressions
+    {
+        Expressions() :
+            document(),
+            editor(),
+            ranges(),
+            primaryRange(-1),
+            keepFormats(false)
+        {}
+
+        QPointer<QTextDocument> document;
+        QPointer<TextEditor::TextEditorWidget> editor;  // Shows the primary range
+        QVector<PinnedRange> ranges;
+        int primaryRange;       // The one under the editor cursor
+        bool keepFormats;       // Replacing all the occurrences of a color
+    };
+
     ColorModifierImpl();
 
     /* functions */
+    bool pinCurrentSelection();
+    void pinSelection(TextEditorWidget *editor);
+    void unpin();
+
+    void writeColor(const QColor &newValue, ColorFormat asFormat);
+    void writeExpressions(Expressions &expressions, const QColor &newValue,
+                          ColorFormat asFormat);
+
+    void showPreview(const QColor &newValue, ColorFormat asFormat);
+    void commitPreview();
+    void clearPreview();
+
+    void beginEditBlock(QTextCursor &cursor);
+    void endEditBlock(QTextCursor &cursor, bool modified);
+
+    /* variables */
+    Expressions pinned;
+    int pinSerial;              // Changes with the pinned expressions
+
+    int decimals[COLOR_FORMAT_COUNT];
+
+    QTimer frameTimer;
+    QColor pendingColor;
+    ColorFormat pendingFormat;
+
+    bool editSession;
+    QPointer<QTextDocument> sessionDocument;    // Holds the undo command of the session
+
+    // The preview keeps its own cursors, copied from the pinned ones when it
+    // starts : it is committed to these expressions whatever is pinned later
+    Expressions previewed;
+    int previewPinSerial;
+    QPointer<ColorPreviewOverlay> previewOverlay;
+    QColor previewValue;                        // Invalid without preview
+    ColorFormat previewFormat;
 };
 
-ColorModifierImpl::ColorModifierImpl()
-{}
+ColorModifierImpl::ColorModifierImpl() :
+    pinned(),
+    pinSerial(0),
+    frameTimer(),
+    pendingColor(),
+    pendingFormat(QCssRgbUCharFormat),
+    editSession(false),
+    sessionDocument(),
+    previewed(),
+    previewPinSerial(-1),
+    previewOverlay(),
+    previewValue(),
+    previewFormat(QCssRgbUCharFormat)
+{
+    std::fill_n(decimals, COLOR_FORMAT_COUNT, DEFAULT_COLOR_DECIMALS);
+
+    frameTimer.setSingleShot(true);
+    frameTimer.setInterval(FRAME_INTERVAL);
+}
+
+bool ColorModifierImpl::pinCurrentSelection()
+{
+    TextEditorWidget *editorWidget = currentEditorWidget();
+    if (!editorWidget)
+        return false;
+
+    pinSelection(editorWidget);
+
+    return true;
+}
+
+void ColorModifierImpl::pinSelection(TextEditorWidget *editor)
+{
+    unpin();
+
+    PinnedRange range;
+    range.cursor = editor->textCursor();
+    range.format = QCssRgbUCharFormat;
+
+    pinned.document = editor->document();
+    pinned.editor = editor;
+    pinned.ranges.append(range);
+    pinned.primaryRange = 0;
+}
+
+void ColorModifierImpl::unpin()
+{
+    pinned = Expressions();
+
+    ++pinSerial;
+}
+
+void ColorModifierImpl::writeColor(const QColor &newValue, ColorFormat asFormat)
+{
+    if (!pinned.document && !pinCurrentSelection()) {
+        traceCancel(TRACE_CHANGE_TO_WRITE);
+        return;
+    }
+
+    writeExpressions(pinned, newValue, asFormat);
+}
+
+void ColorModifierImpl::writeExpressions(Expressions &expressions, const QColor &newValue,
+                                         ColorFormat asFormat)
+{
+    TraceSpan span("ColorModifierImpl::writeExpressions");
+
+    if (!expressions.document) {
+        traceCancel(TRACE_CHANGE_TO_WRITE);
+        return;
+    }
+
+    // A single edit block : one undo step, one highlighting and layout pass
+    QTextCursor batchCursor(expressions.document);
+    beginEditBlock(batchCursor);
+
+    bool modified = false;
+
+    for (PinnedRange &range : expressions.ranges) {
+        const ColorFormat format = (expressions.keepFormats) ? range.format : asFormat;
+        const QString newText = colorToString(newValue, format, decimals[format]);
+
+        if (newText == range.cursor.selectedText())
+            continue;
+
+        replaceSelection(range.cursor, newText);
+
+        modified = true;
+    }
+
+    {
+        // Highlighting and relayout run when the block ends
+        TraceSpan updateSpan("QTextDocument update");
+        endEditBlock(batchCursor, modified);
+    }
+
+    traceEnd(TRACE_CHANGE_TO_WRITE);
+
+    // The editor may have been closed, another split showing the document
+    if (modified && expressions.editor && expressions.primaryRange >= 0)
+        expressions.editor->setTextCursor(expressions.ranges.at(expressions.primaryRange).cursor);
+}
+
+void ColorModifierImpl::showPreview(const QColor &newValue, ColorFormat asFormat)
+{
+    if (!pinned.document && !pinCurrentSelection())
+        return;
+
+    // Anchored once, the next previews only change the text
+    if (!previewValue.isValid() || previewPinSerial != pinSerial) {
+        previewed = pinned;
+        previewPinSerial = pinSerial;
+    }
+
+    previewValue = newValue;
+    previewFormat = asFormat;
+
+    if (!previewed.editor)
+        return;
+
+    QVector<QTextCursor> ranges;
+    QStringList texts;
+
+    for (const PinnedRange &range : previewed.ranges) {
+        const ColorFormat format = (previewed.keepFormats) ? range.format : asFormat;
+
+        ranges.append(range.cursor);
+        texts.append(colorToString(newValue, format, decimals[format]));
+    }
+
+    if (previewOverlay && previewOverlay->editor() != previewed.editor)
+        delete previewOverlay;
+
+    if (!previewOverlay) {
+        previewOverlay = new ColorPreviewOverlay(previewed.editor);
+        previewOverlay->show();
+    }
+
+    previewOverlay->setPreview(ranges, texts);
+}
+
+void ColorModifierImpl::commitPreview()
+{
+    // Copied, clearing the preview resets them
+    Expressions expressions = previewed;
+    const QColor value = previewValue;
+    const ColorFormat format = previewFormat;
+    const bool samePin = (previewPinSerial == pinSerial);
+
+    clearPreview();
+    writeExpressions(expressions, value, format);
+
+    // Their cursors select the written text, the pinned copies may not
+    if (samePin)
+        pinned = expressions;
+}
+
+void ColorModifierImpl::clearPreview()
+{
+    delete previewOverlay;
+
+    previewed = Expressions();
+    previewPinSerial = -1;
+    previewValue = QColor();
+}
+
+void ColorModifierImpl::beginEditBlock(QTextCursor &cursor)
+{
+    // The writes of a session after the first one extend its undo command
+    if (editSession && sessionDocument && sessionDocument == cursor.document())
+        cursor.joinPreviousEditBlock();
+    else
+        cursor.beginEditBlock();
+}
+
+void ColorModifierImpl::endEditBlock(QTextCursor &cursor, bool modified)
+{
+    cursor.endEditBlock();
+
+    // An empty block pushes no undo command, joining it would extend the
+    // command of the previous user edit
+    if (editSession && modified)
+        sessionDocument = cursor.document();
+}
 
 
 ////////////////////////// ColorModifier //////////////////////////
@@ -37,7 +343,8 @@ ColorModifier::ColorModifier(QObject *parent) :
     QObject(parent),
     d(new ColorModifierImpl)
 {
-
+    connect(&d->frameTimer, &QTimer::timeout,
+            this, [=] { d->writeColor(d->pendingColor, d->pendingFormat); });
 }
 
 ColorModifier::~ColorModifier()
@@ -45,26 +352,114 @@ ColorModifier::~ColorModifier()
 
 void ColorModifier::insertColor(const QColor &newValue, ColorFormat asFormat)
 {
-    IEditor *currentEditor = EditorManager::instance()->currentEditor();
-    if (!currentEditor)
-        return;
+    // Written now, the scheduled color would overwrite it
+    d->frameTimer.stop();
+    d->clearPreview();
 
-    auto editorWidget = qobject_cast<TextEditorWidget *>(currentEditor->widget());
-    QTextCursor currentCursor = editorWidget->textCursor();
+    d->writeColor(newValue, asFormat);
+}
 
-    QString newText = colorToString(newValue, asFormat);
+void ColorModifier::scheduleColor(const QColor &newValue, ColorFormat asFormat)
+{
+    d->pendingColor = newValue;
+    d->pendingFormat = asFormat;
+
+    // Not restarted by the next calls, a long drag still writes once per frame
+    if (!d->frameTimer.isActive()) {
+        traceBegin(TRACE_CHANGE_TO_WRITE);
+        d->frameTimer.start();
+    }
+}
 
-    if (newText == currentCursor.selectedText()) {
+void ColorModifier::beginEditSession()
+{
+    d->editSession = true;
+    d->sessionDocument.clear();
+}
+
+void ColorModifier::endEditSession()
+{
+    if (d->frameTimer.isActive())
+        insertColor(d->pendingColor, d->pendingFormat);
+
+    d->editSession = false;
+    d->sessionDocument.clear();
+}
+
+void ColorModifier::previewColor(const QColor &newValue, ColorFormat asFormat)
+{
+    d->showPreview(newValue, asFormat);
+}
+
+void ColorModifier::commitPreview()
+{
+    if (!hasPreview())
         return;
+
+    // The color of the last frame is older than the preview
+    d->frameTimer.stop();
+
+    d->commitPreview();
+}
+
+bool ColorModifier::hasPreview() const
+{
+    return d->previewValue.isValid();
+}
+
+void ColorModifier::setDecimals(ColorFormat format, int decimals)
+{
+    d->decimals[format] = qBound(MIN_COLOR_DECIMALS, decimals, MAX_COLOR_DECIMALS);
+}
+
+void ColorModifier::pinSelection(TextEditorWidget *editor)
+{
+    Q_ASSERT(editor);
+
+    d->pinSelection(editor);
+}
+
+void ColorModifier::pinOccurrences(TextEditorWidget *editor,
+                                   const QVector<ColorIndexEntry> &occurrences)
+{
+    Q_ASSERT(editor);
+
+    d->unpin();
+
+    d->pinned.document = editor->document();
+    d->pinned.editor = editor;
+    d->pinned.keepFormats = true;
+
+    const int cursorPos = editor->textCursor().position();
+
+    for (const ColorIndexEntry &entry : occurrences) {
+        ColorModifierImpl::PinnedRange range;
+        range.cursor = QTextCursor(editor->document());
+        range.cursor.setPosition(entry.offset);
+        range.cursor.setPosition(entry.end(), QTextCursor::KeepAnchor);
+        range.format = entry.format;
+
+        if (d->pinned.primaryRange < 0 && entry.offset <= cursorPos && cursorPos <= entry.end())
+            d->pinned.primaryRange = d->pinned.ranges.size();
+
+        d->pinned.ranges.append(range);
     }
+}
 
-    currentCursor.insertText(newText);
-    currentCursor.movePosition(QTextCursor::Left, QTextCursor::MoveAnchor,
-                               newText.size());
-    currentCursor.movePosition(QTextCursor::Right, QTextCursor::KeepAnchor,
-                               newText.size());
+void ColorModifier::unpin()
+{
+    // The color of the last frame belongs to these expressions
+    if (d->frameTimer.isActive()) {
+        d->frameTimer.stop();
+        d->writeColor(d->pendingColor, d->pendingFormat);
+    }
+
+    d->unpin();
+}
 
-    editorWidget->setTextCursor(currentCursor);
+bool ColorModifier::isPinned() const
+{
+    return !d->pinned.document.isNull();
 }
 
 } // namespace Internal
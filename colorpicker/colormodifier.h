@@ -5,10 +5,15 @@
 
 #include "colorutilities.h"
 
+namespace TextEditor {
+class TextEditorWidget;
+}
+
 namespace ColorPicker {
 namespace Internal {
 
 class ColorModifierImpl;
+struct ColorIndexEntry;
 
 class ColorModifier : public QObject
 {
@@ -20,6 +25,36 @@ public:
 
     void insertColor(const QColor &newValue, ColorFormat asFormat);
 
+    // Live editing : the colors scheduled during a display frame are written
+    // once, at the end of the frame, only the last one being kept
+    void scheduleColor(const QColor &newValue, ColorFormat asFormat);
+
+    // The writes between these calls (e.g. a slider drag) make a single undo
+    // command. Ending the session writes the scheduled color, if any.
+    void beginEditSession();
+    void endEditSession();
+
+    // Draws the text insertColor() would write over the edited expressions,
+    // without modifying the document. commitPreview() writes the last color
+    // previewed, insertColor() discards it.
+    void previewColor(const QColor &newValue, ColorFormat asFormat);
+    void commitPreview();
+    bool hasPreview() const;
+
+    // Decimals of the float components written in this format
+    void setDecimals(ColorFormat format, int decimals);
+
+    // Pins the expressions written by the next calls, until unpinned : the
+    // selection of the editor, or all these occurrences, each one keeping its
+    // format. They are written whatever the current editor is, and follow the
+    // edits of their document. Without pinned expressions, the selection of
+    // the current editor is pinned on the first write.
+    void pinSelection(TextEditor::TextEditorWidget *editor);
+    void pinOccurrences(TextEditor::TextEditorWidget *editor,
+                        const QVector<ColorIndexEntry> &occurrences);
+    void unpin();
+    bool isPinned() const;
+
 private:
     QScopedPointer<ColorModifierImpl> d;
 };
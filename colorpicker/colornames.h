@@ -0,0 +1,23 @@
+#ifndef COLORNAMES_H
+#define COLORNAMES_H
+
+#include <QRgb>
+
+namespace ColorPicker {
+namespace Internal {
+
+// Bounds of the names, "red" and "lightgoldenrodyellow"
+constexpr int COLOR_NAME_MIN_LENGTH = 3;
+constexpr int COLOR_NAME_MAX_LENGTH = 20;
+
+// Looks a lowercase ASCII name up among the 148 CSS named colors and
+// "transparent", through a perfect hash table built at compile time.
+bool findNamedColor(const char *name, int length, QRgb *value);
+
+// First name of this exact value (alpha included), nullptr if there is none
+const char *colorName(QRgb value);
+
+} // namespace Internal
+} // namespace ColorPicker
+
+#endif // COLORNAMES_H
@@ -1,13 +1,9 @@
 #ifndef COLORPICKERCONSTANTS_H
 #define COLORPICKERCONSTANTS_H
 
-#include <string>
+#include <QtGlobal>
 
-#include <QRegularExpression>
-
-#define DECL_QREGEX_CONSTANT(name, regex) \
-    const QRegularExpression name(QString::fromStdString(regex), \
-    QRegularExpression::CaseInsensitiveOption)
+#include "colorutilities.h"
 
 namespace ColorPicker {
 namespace Internal {
@@ -24,133 +20,100 @@ const char COLORPICKER_SETTINGS_TR_CATEGORY[] = QT_TRANSLATE_NOOP("ColorPicker",
 const char COLORPICKER_SETTINGS_CATEGORY_ICON[]  = ":/colorpicker/images/icon.png";
 
 const char ACTION_NAME_TRIGGER_COLOR_EDIT[] = "Trigger Color Edit";
+const char ACTION_NAME_REPLACE_COLOR[] = "Replace All Occurrences";
+const char ACTION_NAME_SCAN_PROJECT_COLORS[] = "Scan Project Colors";
+const char ACTION_NAME_RECOLOR_PROJECT[] = "Recolor Project...";
 
 const char TRIGGER_COLOR_EDIT[] = "ColorPicker.TriggerColorEdit";
-
-
-////////////////////////// Regex parts //////////////////////////
-
-const std::string _RXPART_0_TO_255 = "([0-9]|[1-9][0-9]|1[0-9][0-9]|2[0-4][0-9]|25[0-5])";
-const std::string _RXPART_0_TO_359 = "([0-9]|[1-9][0-9]|[1|2][0-9][0-9]|3[0-5][0-9])";
-const std::string _RXPART_PERCENTAGE = "([0-9]|[1-9][0-9]|100)\\%?";
-const std::string _RXPART_FLOAT_LITERAL = "([0]?\\.[0-9]*|1\\.0|1|0)[f]";
-const std::string _RXPART_FLOAT_VALUE = "(0|1|1.0|0*\\.\\d+)";
-const std::string _RXPART_BLANK = "\\s*?";
-
-
-////////////////////////// Regex //////////////////////////
-
-// Qss-Css colors
-DECL_QREGEX_CONSTANT(REGEX_QCSS_RGB_UCHAR,
-                     "rgb" + _RXPART_BLANK
-                     + "\\(" + _RXPART_BLANK
-                     + _RXPART_0_TO_255 + _RXPART_BLANK + "," + _RXPART_BLANK
-                     + _RXPART_0_TO_255 + _RXPART_BLANK + "," + _RXPART_BLANK
-                     + _RXPART_0_TO_255 + _RXPART_BLANK
-                     + "\\)");
-
-DECL_QREGEX_CONSTANT(REGEX_QCSS_RGBA_UCHAR,
-                     "rgba" + _RXPART_BLANK
-                     + "\\(" + _RXPART_BLANK
-                     + _RXPART_0_TO_255 + _RXPART_BLANK + "," + _RXPART_BLANK
-                     + _RXPART_0_TO_255 + _RXPART_BLANK + "," + _RXPART_BLANK
-                     + _RXPART_0_TO_255 + _RXPART_BLANK + "," + _RXPART_BLANK
-                     + _RXPART_FLOAT_VALUE + _RXPART_BLANK
-                     + "\\)");
-
-DECL_QREGEX_CONSTANT(REGEX_QCSS_RGB_PERCENT,
-                     "rgb" + _RXPART_BLANK
-                     + "\\(" + _RXPART_BLANK
-                     + _RXPART_PERCENTAGE + _RXPART_BLANK + "," + _RXPART_BLANK
-                     + _RXPART_PERCENTAGE + _RXPART_BLANK + "," + _RXPART_BLANK
-                     + _RXPART_PERCENTAGE + _RXPART_BLANK
-                     + "\\)");
-
-DECL_QREGEX_CONSTANT(REGEX_QCSS_RGBA_PERCENT,
-                     "rgba" + _RXPART_BLANK
-                     + "\\(" + _RXPART_BLANK
-                     + _RXPART_PERCENTAGE + _RXPART_BLANK + "," + _RXPART_BLANK
-                     + _RXPART_PERCENTAGE + _RXPART_BLANK + "," + _RXPART_BLANK
-                     + _RXPART_PERCENTAGE + _RXPART_BLANK + "," + _RXPART_BLANK
-                     + _RXPART_FLOAT_VALUE + _RXPART_BLANK
-                     + "\\)");
-
-// Qss colors
-DECL_QREGEX_CONSTANT(REGEX_QSS_HSV,
-                     "hsv" + _RXPART_BLANK
-                     + "\\(" + _RXPART_BLANK
-                     + _RXPART_0_TO_359  + _RXPART_BLANK + "," + _RXPART_BLANK
-                     + _RXPART_0_TO_255  + _RXPART_BLANK + "," + _RXPART_BLANK
-                     + _RXPART_0_TO_255 + _RXPART_BLANK
-                     + "\\)");
-
-DECL_QREGEX_CONSTANT(REGEX_QSS_HSVA,
-                     "hsva" + _RXPART_BLANK
-                     + "\\(" + _RXPART_BLANK
-                     + _RXPART_0_TO_359 + _RXPART_BLANK + "," + _RXPART_BLANK
-                     + _RXPART_0_TO_255  + _RXPART_BLANK + ","  + _RXPART_BLANK
-                     + _RXPART_0_TO_255  + _RXPART_BLANK + ","  + _RXPART_BLANK
-                     + _RXPART_PERCENTAGE + _RXPART_BLANK
-                     + "\\)");
-
-// Css colors
-DECL_QREGEX_CONSTANT(REGEX_CSS_HSL,
-                     "hsl" + _RXPART_BLANK
-                     + "\\(" + _RXPART_BLANK
-                     + _RXPART_0_TO_359  + _RXPART_BLANK + "," + _RXPART_BLANK
-                     + _RXPART_PERCENTAGE  + _RXPART_BLANK + "," + _RXPART_BLANK
-                     + _RXPART_PERCENTAGE + _RXPART_BLANK
-                     + "\\)");
-
-DECL_QREGEX_CONSTANT(REGEX_CSS_HSLA,
-                     "hsla" + _RXPART_BLANK
-                     + "\\(" + _RXPART_BLANK
-                     + _RXPART_0_TO_359 + _RXPART_BLANK + "," + _RXPART_BLANK
-                     + _RXPART_PERCENTAGE  + _RXPART_BLANK + ","  + _RXPART_BLANK
-                     + _RXPART_PERCENTAGE  + _RXPART_BLANK + ","  + _RXPART_BLANK
-                     + _RXPART_FLOAT_VALUE + _RXPART_BLANK
-                     + "\\)");
-
-// Qml colors
-DECL_QREGEX_CONSTANT(REGEX_QML_RGBA,
-                     "Qt.rgba" + _RXPART_BLANK
-                     + "\\(" + _RXPART_BLANK
-                     + _RXPART_FLOAT_VALUE + _RXPART_BLANK + "," + _RXPART_BLANK
-                     + _RXPART_FLOAT_VALUE + _RXPART_BLANK + "," + _RXPART_BLANK
-                     + _RXPART_FLOAT_VALUE + _RXPART_BLANK + "," + _RXPART_BLANK
-                     + _RXPART_FLOAT_VALUE + _RXPART_BLANK + _RXPART_BLANK
-                     + "\\)");
-
-DECL_QREGEX_CONSTANT(REGEX_QML_HSLA,
-                     "Qt.hsla" + _RXPART_BLANK
-                     + "\\(" + _RXPART_BLANK
-                     + _RXPART_FLOAT_VALUE + _RXPART_BLANK + "," + _RXPART_BLANK
-                     + _RXPART_FLOAT_VALUE + _RXPART_BLANK + "," + _RXPART_BLANK
-                     + _RXPART_FLOAT_VALUE + _RXPART_BLANK + "," + _RXPART_BLANK
-                     + _RXPART_FLOAT_VALUE + _RXPART_BLANK + _RXPART_BLANK
-                     + "\\)");
-
-// OpenGL colors
-DECL_QREGEX_CONSTANT(REGEX_VEC3,
-                     "vec3" + _RXPART_BLANK
-                     + "\\(" + _RXPART_BLANK
-                     + _RXPART_FLOAT_VALUE + _RXPART_BLANK + "," + _RXPART_BLANK
-                     + _RXPART_FLOAT_VALUE + _RXPART_BLANK + "," + _RXPART_BLANK
-                     + _RXPART_FLOAT_VALUE + _RXPART_BLANK
-                     + "\\)");
-
-DECL_QREGEX_CONSTANT(REGEX_VEC4,
-                     "vec4" + _RXPART_BLANK
-                     + "\\(" + _RXPART_BLANK
-                     + _RXPART_FLOAT_VALUE + _RXPART_BLANK + "," + _RXPART_BLANK
-                     + _RXPART_FLOAT_VALUE + _RXPART_BLANK + "," + _RXPART_BLANK
-                     + _RXPART_FLOAT_VALUE + _RXPART_BLANK + "," + _RXPART_BLANK
-                     + _RXPART_FLOAT_VALUE + _RXPART_BLANK
-                     + "\\)");
-
-// Other colors
-DECL_QREGEX_CONSTANT(REGEX_HEXCOLOR,
-                     "(\\#[a-f0-9]{12}|\\#[a-f0-9]{9}|\\#[a-f0-9]{8}|\\#[a-f0-9]{6}|\\#[a-f0-9]{3})");
+const char REPLACE_COLOR[] = "ColorPicker.ReplaceColor";
+const char SCAN_PROJECT_COLORS[] = "ColorPicker.ScanProjectColors";
+const char RECOLOR_PROJECT[] = "ColorPicker.RecolorProject";
+
+const char TASK_SCAN_PROJECT_COLORS[] = "ColorPicker.Task.ScanProjectColors";
+const char TASK_RECOLOR_PROJECT[] = "ColorPicker.Task.RecolorProject";
+
+
+////////////////////////// Grammar parts //////////////////////////
+
+// A numeric component of a color expression. Integer components are written
+// without leading zeros, float components are 0, 1, 1.0 or 0*.[0-9]+
+struct ComponentRule
+{
+    int maxInteger;             // Upper bound of an integer component, -1 for a float
+    bool percentSign;           // Whether the component may be followed by '%'
+};
+
+constexpr ComponentRule GRAMMAR_0_TO_255 = { 255, false };
+constexpr ComponentRule GRAMMAR_0_TO_359 = { 359, false };
+constexpr ComponentRule GRAMMAR_PERCENTAGE = { 100, true };
+constexpr ComponentRule GRAMMAR_FLOAT_VALUE = { -1, false };
+
+// keyword ( component , component , ... )
+// The keyword is case insensitive, blanks are allowed around each token.
+struct PatternRule
+{
+    ColorFormat format;
+    const char *keyword;
+    int componentCount;
+    ComponentRule components[4];
+};
+
+
+////////////////////////// Grammar //////////////////////////
+
+// When several patterns match the same expression, the first one wins
+constexpr PatternRule COLOR_GRAMMAR[] =
+{
+    // Qss-Css colors
+    { QCssRgbUCharFormat, "rgb", 3,
+      { GRAMMAR_0_TO_255, GRAMMAR_0_TO_255, GRAMMAR_0_TO_255 } },
+    { QCssRgbUCharFormat, "rgba", 4,
+      { GRAMMAR_0_TO_255, GRAMMAR_0_TO_255, GRAMMAR_0_TO_255, GRAMMAR_FLOAT_VALUE } },
+    { QCssRgbPercentFormat, "rgb", 3,
+      { GRAMMAR_PERCENTAGE, GRAMMAR_PERCENTAGE, GRAMMAR_PERCENTAGE } },
+    { QCssRgbPercentFormat, "rgba", 4,
+      { GRAMMAR_PERCENTAGE, GRAMMAR_PERCENTAGE, GRAMMAR_PERCENTAGE, GRAMMAR_FLOAT_VALUE } },
+
+    // Qss colors
+    { QssHsvFormat, "hsv", 3,
+      { GRAMMAR_0_TO_359, GRAMMAR_0_TO_255, GRAMMAR_0_TO_255 } },
+    { QssHsvFormat, "hsva", 4,
+      { GRAMMAR_0_TO_359, GRAMMAR_0_TO_255, GRAMMAR_0_TO_255, GRAMMAR_PERCENTAGE } },
+
+    // Css colors
+    { CssHslFormat, "hsl", 3,
+      { GRAMMAR_0_TO_359, GRAMMAR_PERCENTAGE, GRAMMAR_PERCENTAGE } },
+    { CssHslFormat, "hsla", 4,
+      { GRAMMAR_0_TO_359, GRAMMAR_PERCENTAGE, GRAMMAR_PERCENTAGE, GRAMMAR_FLOAT_VALUE } },
+
+    // Qml colors
+    { QmlRgbaFormat, "qt.rgba", 4,
+      { GRAMMAR_FLOAT_VALUE, GRAMMAR_FLOAT_VALUE, GRAMMAR_FLOAT_VALUE, GRAMMAR_FLOAT_VALUE } },
+    { QmlHslaFormat, "qt.hsla", 4,
+      { GRAMMAR_FLOAT_VALUE, GRAMMAR_FLOAT_VALUE, GRAMMAR_FLOAT_VALUE, GRAMMAR_FLOAT_VALUE } },
+
+    // OpenGL colors
+    { GlslFormat, "vec3", 3,
+      { GRAMMAR_FLOAT_VALUE, GRAMMAR_FLOAT_VALUE, GRAMMAR_FLOAT_VALUE } },
+    { GlslFormat, "vec4", 4,
+      { GRAMMAR_FLOAT_VALUE, GRAMMAR_FLOAT_VALUE, GRAMMAR_FLOAT_VALUE, GRAMMAR_FLOAT_VALUE } }
+};
+
+constexpr int COLOR_GRAMMAR_SIZE = sizeof(COLOR_GRAMMAR) / sizeof(PatternRule);
+
+// Other colors : #FFFFFFFFFFFF | #FFFFFFFFF | #FFFFFFFF | #FFFFFF | #FFF
+constexpr int GRAMMAR_HEX_DIGIT_COUNTS[] = { 12, 9, 8, 6, 3 };
+
+// Longest expression of the grammar, e.g.
+// "Qt.hsla( 0.12345, 0.12345, 0.12345, 0.12345 )" with generous blanks.
+// Blanks and float digits being unbounded otherwise, longer expressions are
+// rejected by every scan, so that looking this far around the cursor finds
+// the same expressions as scanning the whole line.
+constexpr int GRAMMAR_MAX_EXPRESSION_LENGTH = 96;
+
+// Lines longer than this are not scanned entirely, only a window of
+// GRAMMAR_MAX_EXPRESSION_LENGTH characters on each side of the cursor.
+constexpr int WINDOWED_DETECTION_MIN_LINE_LENGTH = 4096;
 
 } // namespace Constants
 } // namespace Internal
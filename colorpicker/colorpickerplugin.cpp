@@ -2,34 +2,69 @@
 #include "colorpickerplugin_p.h"
 
 // Qt includes
+#include <QCryptographicHash>
+#include <QDir>
+#include <QLayout>
+#include <QLoggingCategory>
 #include <QMenu>
 
 // QtCreator includes
 #include <coreplugin/actionmanager/actioncontainer.h>
 #include <coreplugin/actionmanager/actionmanager.h>
+#include <coreplugin/editormanager/documentmodel.h>
 #include <coreplugin/editormanager/editormanager.h>
 #include <coreplugin/icore.h>
+#include <coreplugin/idocument.h>
 #include <coreplugin/editormanager/ieditor.h>
+#include <coreplugin/messagemanager.h>
+#include <coreplugin/progressmanager/progressmanager.h>
 
 #include <cppeditor/cppeditorconstants.h>
 #include <extensionsystem/pluginmanager.h>
 #include <glsleditor/glsleditorconstants.h>
+#include <projectexplorer/project.h>
+#include <projectexplorer/projecttree.h>
+#include <projectexplorer/session.h>
 #include <qmljseditor/qmljseditorconstants.h>
 #include <texteditor/texteditor.h>
 #include <utils/theme/theme.h>
 
 // Plugin includes
+#include "colorindex.h"
 #include "colormodifier.h"
 #include "colorpickeroptionspage.h"
 #include "colorpickerconstants.h"
+#include "colortrace.h"
 #include "colorwatcher.h"
+#include "projectcolorscanner.h"
+#include "projectrecolor.h"
 
 #include "widgets/coloreditor.h"
 #include "widgets/coloreditordialog.h"
+#include "widgets/recolordialog.h"
 
 using namespace Core;
+using namespace ProjectExplorer;
 using namespace TextEditor;
 
+namespace {
+
+// QT_LOGGING_RULES="qtc.colorpicker.startup=true" prints what the plugin costs
+// at launch
+Q_LOGGING_CATEGORY(startupLog, "qtc.colorpicker.startup")
+
+// QT_LOGGING_RULES="qtc.colorpicker.watchers=true" prints the watchers and the
+// memory of their caches when editors are closed or caches released
+Q_LOGGING_CATEGORY(watchersLog, "qtc.colorpicker.watchers")
+
+// Watchers of the other editors free their cached colors
+const int MAX_CACHED_WATCHERS = 8;
+
+// ms, the file list of a project changes many times while it is parsed
+const int RESCAN_DELAY = 1000;
+
+} // anon namespace
+
 namespace ColorPicker {
 namespace Internal {
 
@@ -39,8 +74,19 @@ namespace Internal {
 ColorPickerPluginImpl::ColorPickerPluginImpl(ColorPickerPlugin *qq) :
     q(qq),
     watchers(),
+    recentEditors(),
     colorModifier(new ColorModifier(qq)),
     colorEditorDialog(nullptr),
+    projectColorScanner(new ProjectColorScanner(qq)),
+    projectRecolor(new ProjectRecolor(qq)),
+    scannedProject(),
+    rescanTimer(),
+    reportScan(false),
+    scanTimer(),
+    startupTimer(),
+    initializeTime(0),
+    extensionsInitializedTime(0),
+    dialogPrewarmTime(0),
     generalSettings()
 {}
 
@@ -84,8 +130,255 @@ QPoint ColorPickerPluginImpl::clampColorEditorPosition(const QPoint &cursorPos,
     return ret;
 }
 
+ProjectExplorer::Project *ColorPickerPluginImpl::currentProject() const
+{
+    ProjectExplorer::Project *ret = ProjectTree::currentProject();
+    if (!ret)
+        ret = SessionManager::startupProject();
+
+    return ret;
+}
+
+QString ColorPickerPluginImpl::indexFileName(ProjectExplorer::Project *project) const
+{
+    const QByteArray projectHash = QCryptographicHash::hash(
+                project->projectFilePath().toString().toUtf8(), QCryptographicHash::Sha1);
+
+    const QString dirPath = ICore::userResourcePath() + QLatin1String("/colorpicker");
+    QDir().mkpath(dirPath);
+
+    return dirPath + QLatin1Char('/') + QString::fromLatin1(projectHash.toHex())
+            + QLatin1String(".colors");
+}
+
+void ColorPickerPluginImpl::scanProject(ProjectExplorer::Project *project)
+{
+    // The previous project keeps its index on disk for the next session
+    if (project != scannedProject) {
+        releaseScannedProject();
+
+        scannedProject = project;
+
+        projectColorScanner->loadIndex(indexFileName(project));
+
+        QObject::connect(project, &ProjectExplorer::Project::fileListChanged,
+                         q, &ColorPickerPlugin::onProjectFileListChanged);
+    }
+
+    rescanTimer.stop();
+    scanTimer.start();
+
+    QFuture<FileColors> future =
+            projectColorScanner->start(project->files(ProjectExplorer::Project::SourceFiles));
+
+    ProgressManager::addTask(QFuture<void>(future),
+                             ColorPickerPlugin::tr("Scanning colors of %1")
+                             .arg(project->displayName()),
+                             Constants::TASK_SCAN_PROJECT_COLORS);
+}
+
+void ColorPickerPluginImpl::releaseScannedProject()
+{
+    if (!scannedProject)
+        return;
+
+    rescanTimer.stop();
+    projectColorScanner->cancel();
+    projectColorScanner->saveIndex(indexFileName(scannedProject));
+
+    QObject::disconnect(scannedProject, &ProjectExplorer::Project::fileListChanged,
+                        q, &ColorPickerPlugin::onProjectFileListChanged);
+
+    scannedProject = nullptr;
+}
+
+ColorWatcher *ColorPickerPluginImpl::watcherForEditor(IEditor *editor,
+                                                     TextEditorWidget *editorWidget)
+{
+    // Create a watcher or apply an existing one to the texteditor
+    ColorWatcher *ret = watchers.value(editor);
+
+    if (!ret) {
+        ColorCategory cat = (generalSettings.m_editorSensitive)
+                ? colorCategoryForEditor(editor)
+                : ColorCategory::AnyCategory;
+
+        ret = new ColorWatcher(editorWidget);
+        ret->setColorCategory(cat);
+        ret->setSwatchesVisible(generalSettings.m_showSwatches);
+        ret->setTooltipsEnabled(generalSettings.m_showTooltips);
+
+        // The clicked editor is edited, whichever split is the current one
+        QObject::connect(ret, &ColorWatcher::swatchClicked,
+                         q, [=] { editColorUnderCursor(editor, false); });
+
+        // A released watcher is tracked again when anything refills its cache,
+        // so that the bound holds for the swatches and tooltips of other splits
+        QObject::connect(ret, &ColorWatcher::cacheFilled,
+                         q, [=] { touchWatcher(editor); });
+
+        // Owned by the editor widget, which may go away without the editor
+        // being closed through the editor manager
+        QObject::connect(ret, &QObject::destroyed,
+                         q, [=] { forgetWatcher(editor); });
+
+        watchers.insert(editor, ret);
+    }
+
+    return ret;
+}
+
+void ColorPickerPluginImpl::touchWatcher(IEditor *editor)
+{
+    if (!watchers.contains(editor))
+        return;
+
+    recentEditors.removeOne(editor);
+    recentEditors.prepend(editor);
+
+    if (recentEditors.size() <= MAX_CACHED_WATCHERS)
+        return;
+
+    // Only the least recently used one is over the bound
+    watchers.value(recentEditors.takeLast())->releaseCache();
+
+    logWatchers();
+}
+
+void ColorPickerPluginImpl::forgetWatcher(IEditor *editor)
+{
+    if (!watchers.remove(editor))
+        return;
+
+    recentEditors.removeOne(editor);
+
+    logWatchers();
+}
+
+void ColorPickerPluginImpl::logWatchers() const
+{
+    if (!watchersLog().isDebugEnabled())
+        return;
+
+    qint64 totalMemory = 0;
+
+    for (auto it = watchers.cbegin(); it != watchers.cend(); ++it) {
+        const qint64 memory = it.value()->cacheMemory();
+        totalMemory += memory;
+
+        qCDebug(watchersLog, "  %s: %lld bytes",
+                qPrintable(it.key()->document()->filePath().toUserOutput()),
+                memory);
+    }
+
+    qCDebug(watchersLog, "%d watchers, %d recently used, %lld bytes cached",
+            watchers.size(), recentEditors.size(), totalMemory);
+}
+
+void ColorPickerPluginImpl::editColorUnderCursor(IEditor *editor, bool replaceAll)
+{
+    TraceSpan span("ColorPickerPluginImpl::editColorUnderCursor");
+
+    // Showing the dialog paints the color picker, a visible one may not repaint
+    if (!colorEditorDialog || colorEditorDialog->isHidden())
+        traceBegin(TRACE_TRIGGER_TO_PAINT);
+
+    // The previous edit ends here
+    colorModifier->commitPreview();
+    colorModifier->unpin();
+
+    if (!editor) {
+        traceCancel(TRACE_TRIGGER_TO_PAINT);
+        return;
+    }
+
+    auto editorWidget = qobject_cast<TextEditorWidget *>(editor->widget());
+
+    if (editorWidget) {
+        ColorCategory cat = (generalSettings.m_editorSensitive)
+                ? colorCategoryForEditor(editor)
+                : ColorCategory::AnyCategory;
+
+        ColorWatcher *watcher = watcherForEditor(editor, editorWidget);
+        touchWatcher(editor);
+
+        // Process the color under cursor
+        ColorExpr toEdit = watcher->process();
+
+        // The next edits go to every occurrence of the processed color
+        if (replaceAll && toEdit.value.isValid()) {
+            QVector<ColorIndexEntry> occurrences;
+
+            for (const ColorIndexEntry &entry : watcher->colorsInDocument()) {
+                if (colorsMatch(entry.value, toEdit.value, generalSettings.m_replaceTolerance))
+                    occurrences.append(entry);
+            }
+
+            colorModifier->pinOccurrences(editorWidget, occurrences);
+        }
+        else {
+            colorModifier->pinSelection(editorWidget);
+        }
+
+        // Show and move the dialog
+        {
+            TraceSpan showSpan("ColorEditorDialog::show");
+            editorDialog()->show();
+        }
+
+        QWidget *editorViewport = editorWidget->viewport();
+        QPoint newPos = clampColorEditorPosition(toEdit.pos,
+                                                 editorViewport->rect());
+        colorEditorDialog->move(editorViewport->mapToGlobal(newPos));
+
+        // Update the color dialog to reflect the processed color
+        Q_ASSERT(colorEditorDialog);
+        ColorEditor *colorEditor = colorEditorDialog->colorWidget();
+        colorEditor->setColorCategory(cat);
+
+        QColor newColor;
+
+        if (toEdit.value.isValid()) {
+            newColor = toEdit.value;
+
+            const QSignalBlocker blocker(colorEditor);
+            colorEditor->setOutputFormat(toEdit.format);
+        } else {
+            newColor = colorEditor->color();
+        }
+
+        colorEditor->setColor(newColor);
+    }
+    else {
+        traceCancel(TRACE_TRIGGER_TO_PAINT);
+    }
+}
+
+ColorEditorDialog *ColorPickerPluginImpl::editorDialog()
+{
+    if (colorEditorDialog)
+        return colorEditorDialog;
+
+    colorEditorDialog = new ColorEditorDialog(Core::ICore::mainWindow());
+
+    QObject::connect(colorEditorDialog->colorWidget(), &ColorEditor::colorSelected,
+                     q, &ColorPickerPlugin::onColorSelected);
+
+    // Closing the dialog validates the previewed color
+    QObject::connect(colorEditorDialog, &ColorEditorDialog::finished,
+                     q, [=] { colorModifier->commitPreview(); });
+
+    setInsertOnChange(generalSettings.m_insertOnChange);
+
+    return colorEditorDialog;
+}
+
 void ColorPickerPluginImpl::setInsertOnChange(bool enable)
 {
+    // Connected when the dialog is created
+    if (!colorEditorDialog)
+        return;
+
     ColorEditor *colorEditor = colorEditorDialog->colorWidget();
 
     if (enable) {
@@ -94,6 +387,12 @@ void ColorPickerPluginImpl::setInsertOnChange(bool enable)
 
         QObject::connect(colorEditor, &ColorEditor::outputFormatChanged,
                          q, &ColorPickerPlugin::onOutputFormatChanged);
+
+        QObject::connect(colorEditor, &ColorEditor::editStarted,
+                         colorModifier, &ColorModifier::beginEditSession);
+
+        QObject::connect(colorEditor, &ColorEditor::editFinished,
+                         colorModifier, &ColorModifier::endEditSession);
     }
     else {
         QObject::disconnect(colorEditor, &ColorEditor::colorChanged,
@@ -101,6 +400,15 @@ void ColorPickerPluginImpl::setInsertOnChange(bool enable)
 
         QObject::disconnect(colorEditor, &ColorEditor::outputFormatChanged,
                             q, &ColorPickerPlugin::onOutputFormatChanged);
+
+        QObject::disconnect(colorEditor, &ColorEditor::editStarted,
+                            colorModifier, &ColorModifier::beginEditSession);
+
+        QObject::disconnect(colorEditor, &ColorEditor::editFinished,
+                            colorModifier, &ColorModifier::endEditSession);
+
+        colorModifier->endEditSession();
+        colorModifier->commitPreview();
     }
 }
 
@@ -116,10 +424,6 @@ void ColorPickerPluginImpl::editorSensitiveSettingChanged(bool isSensitive)
         watcher->setColorCategory(newCat);
 
         // Update the color editor
-        auto editorWidget = qobject_cast<TextEditorWidget *>(editor->widget());
-
-        Q_ASSERT(editorWidget);
-
         if (colorEditorDialog) {
             colorEditorDialog->colorWidget()->setColorCategory(newCat);
         }
@@ -131,6 +435,58 @@ void ColorPickerPluginImpl::insertOnChangeSettingChanged(bool insertOnChange)
     setInsertOnChange(insertOnChange);
 }
 
+void ColorPickerPluginImpl::previewChangesSettingChanged(bool previewChanges)
+{
+    // The next changes are written directly
+    if (!previewChanges)
+        colorModifier->commitPreview();
+}
+
+void ColorPickerPluginImpl::showSwatchesSettingChanged(bool showSwatches)
+{
+    if (!showSwatches) {
+        for (ColorWatcher *watcher : watchers)
+            watcher->setSwatchesVisible(false);
+
+        return;
+    }
+
+    generalSettings.m_showSwatches = true;
+
+    for (IEditor *editor : DocumentModel::editorsForOpenedDocuments()) {
+        if (auto editorWidget = qobject_cast<TextEditorWidget *>(editor->widget()))
+            watcherForEditor(editor, editorWidget)->setSwatchesVisible(true);
+    }
+}
+
+void ColorPickerPluginImpl::decimalsSettingChanged(int qmlDecimals, int glslDecimals)
+{
+    colorModifier->setDecimals(QmlRgbaFormat, qmlDecimals);
+    colorModifier->setDecimals(QmlHslaFormat, qmlDecimals);
+    colorModifier->setDecimals(GlslFormat, glslDecimals);
+
+    projectRecolor->setDecimals(QmlRgbaFormat, qmlDecimals);
+    projectRecolor->setDecimals(QmlHslaFormat, qmlDecimals);
+    projectRecolor->setDecimals(GlslFormat, glslDecimals);
+}
+
+void ColorPickerPluginImpl::showTooltipsSettingChanged(bool showTooltips)
+{
+    if (!showTooltips) {
+        for (ColorWatcher *watcher : watchers)
+            watcher->setTooltipsEnabled(false);
+
+        return;
+    }
+
+    generalSettings.m_showTooltips = true;
+
+    for (IEditor *editor : DocumentModel::editorsForOpenedDocuments()) {
+        if (auto editorWidget = qobject_cast<TextEditorWidget *>(editor->widget()))
+            watcherForEditor(editor, editorWidget)->setTooltipsEnabled(true);
+    }
+}
+
 
 ////////////////////////// ColorPickerPlugin //////////////////////////
 
@@ -141,8 +497,19 @@ ColorPickerPlugin::ColorPickerPlugin() :
 
 ColorPickerPlugin::~ColorPickerPlugin()
 {
-    d->colorEditorDialog->deleteLater();
-    d->colorEditorDialog = nullptr;
+    d->releaseScannedProject();
+
+    if (traceLog().isDebugEnabled()) {
+        const QString traceFile = traceFileName();
+
+        if (writeTrace(traceFile))
+            qCDebug(traceLog, "trace written to %s", qPrintable(traceFile));
+    }
+
+    if (d->colorEditorDialog) {
+        d->colorEditorDialog->deleteLater();
+        d->colorEditorDialog = nullptr;
+    }
 }
 
 bool ColorPickerPlugin::initialize(const QStringList &arguments,
@@ -151,8 +518,12 @@ bool ColorPickerPlugin::initialize(const QStringList &arguments,
     Q_UNUSED(arguments);
     Q_UNUSED(errorMessage);
 
+    d->startupTimer.start();
+
     auto optionsPage = new ColorPickerOptionsPage;
     d->generalSettings = optionsPage->generalSettings();
+    d->decimalsSettingChanged(d->generalSettings.m_qmlDecimals,
+                              d->generalSettings.m_glslDecimals);
 
     connect(optionsPage, &ColorPickerOptionsPage::generalSettingsChanged,
             this, &ColorPickerPlugin::onGeneralSettingsChanged);
@@ -175,82 +546,226 @@ bool ColorPickerPlugin::initialize(const QStringList &arguments,
     connect(triggerColorEditAction, &QAction::triggered,
             this, &ColorPickerPlugin::onColorEditTriggered);
 
+    auto replaceColorAction = new QAction(tr(Constants::ACTION_NAME_REPLACE_COLOR), this);
+    command = ActionManager::registerAction(replaceColorAction,
+                                            Constants::REPLACE_COLOR);
+    command->setDefaultKeySequence(QKeySequence(tr("Ctrl+Alt+Shift+C")));
+
+    myContainer->addAction(command);
+
+    connect(replaceColorAction, &QAction::triggered,
+            this, &ColorPickerPlugin::onReplaceColorTriggered);
+
+    auto scanProjectColorsAction = new QAction(tr(Constants::ACTION_NAME_SCAN_PROJECT_COLORS), this);
+    command = ActionManager::registerAction(scanProjectColorsAction,
+                                            Constants::SCAN_PROJECT_COLORS);
+
+    myContainer->addAction(command);
+
+    connect(scanProjectColorsAction, &QAction::triggered,
+            this, &ColorPickerPlugin::onScanProjectColorsTriggered);
+
+    connect(d->projectColorScanner, &ProjectColorScanner::finished,
+            this, &ColorPickerPlugin::onProjectColorsScanned);
+
+    d->rescanTimer.setSingleShot(true);
+    d->rescanTimer.setInterval(RESCAN_DELAY);
+
+    connect(&d->rescanTimer, &QTimer::timeout,
+            this, [=] {
+        if (d->scannedProject)
+            d->scanProject(d->scannedProject);
+    });
+
+    auto recolorProjectAction = new QAction(tr(Constants::ACTION_NAME_RECOLOR_PROJECT), this);
+    command = ActionManager::registerAction(recolorProjectAction,
+                                            Constants::RECOLOR_PROJECT);
+
+    myContainer->addAction(command);
+
+    connect(recolorProjectAction, &QAction::triggered,
+            this, &ColorPickerPlugin::onRecolorProjectTriggered);
+
+    connect(d->projectRecolor, &ProjectRecolor::applied,
+            this, &ColorPickerPlugin::onProjectRecolored);
+
+    // Keep the color index of the startup project up to date
+    SessionManager *sessionManager = SessionManager::instance();
+
+    connect(sessionManager, &SessionManager::startupProjectChanged,
+            this, &ColorPickerPlugin::onStartupProjectChanged);
+
+    connect(sessionManager, &SessionManager::aboutToRemoveProject,
+            this, [=](Project *project) {
+        if (project == d->scannedProject)
+            d->releaseScannedProject();
+    });
+
     toolsContainer->addMenu(myContainer);
 
     // Register objects
     addAutoReleasedObject(optionsPage);
 
+    d->initializeTime = d->startupTimer.nsecsElapsed();
+
     return true;
 }
 
 void ColorPickerPlugin::extensionsInitialized()
 {
-    // Creates the color editor dialog
-    d->colorEditorDialog = new ColorEditorDialog(Core::ICore::mainWindow());
+    d->startupTimer.restart();
+
+    // The color editor dialog is created by delayedInitialize()
+
+    // Swatches and tooltips are shown in every text editor
+    EditorManager *editorManager = EditorManager::instance();
 
-    connect(d->colorEditorDialog->colorWidget(), &ColorEditor::colorSelected,
-            this, &ColorPickerPlugin::onColorSelected);
+    connect(editorManager, &EditorManager::editorOpened,
+            this, [=](IEditor *editor) {
+        auto editorWidget = qobject_cast<TextEditorWidget *>(editor->widget());
+
+        if (editorWidget && (d->generalSettings.m_showSwatches
+                             || d->generalSettings.m_showTooltips)) {
+            d->watcherForEditor(editor, editorWidget);
+        }
+    });
+
+    connect(editorManager, &EditorManager::currentEditorChanged,
+            this, [=](IEditor *editor) {
+        d->touchWatcher(editor);
 
-    d->setInsertOnChange(d->generalSettings.m_insertOnChange);
+        // Replacing all the occurrences reads the index of the document,
+        // built ahead in the background
+        if (ColorWatcher *watcher = d->watchers.value(editor))
+            watcher->colorIndex();
+    });
+
+    connect(editorManager, &EditorManager::editorsClosed,
+            this, [=](const QList<IEditor *> &editors) {
+        for (IEditor *editor : editors)
+            d->forgetWatcher(editor);
+    });
+
+    d->extensionsInitializedTime = d->startupTimer.nsecsElapsed();
+}
+
+bool ColorPickerPlugin::delayedInitialize()
+{
+    // Runs when the application is idle after startup : the dialog is built
+    // and rendered offscreen once (layouts, style, gradient image of the
+    // color picker), so that the first trigger only shows it
+    d->startupTimer.restart();
+
+    ColorEditorDialog *dialog = d->editorDialog();
+    dialog->layout()->activate();
+    dialog->grab();
+
+    d->dialogPrewarmTime = d->startupTimer.nsecsElapsed();
+
+    // The color grammar and the keyword automaton are compile-time tables,
+    // nothing runs before initialize()
+    qCDebug(startupLog, "initialize: %.3f ms, extensionsInitialized: %.3f ms, "
+            "dialog prewarm: %.3f ms",
+            d->initializeTime / 1e6, d->extensionsInitializedTime / 1e6,
+            d->dialogPrewarmTime / 1e6);
+
+    return false;
 }
 
 void ColorPickerPlugin::onColorEditTriggered()
 {
-    IEditor *currentEditor = EditorManager::instance()->currentEditor();
-    if (!currentEditor)
+    d->editColorUnderCursor(EditorManager::instance()->currentEditor(), false);
+}
+
+void ColorPickerPlugin::onReplaceColorTriggered()
+{
+    d->editColorUnderCursor(EditorManager::instance()->currentEditor(), true);
+}
+
+void ColorPickerPlugin::onScanProjectColorsTriggered()
+{
+    Project *project = d->currentProject();
+
+    if (!project) {
+        MessageManager::write(tr("ColorPicker: no project to scan."));
         return;
+    }
 
-    auto editorWidget = qobject_cast<TextEditorWidget *>(currentEditor->widget());
+    d->reportScan = true;
+    d->scanProject(project);
+}
 
-    if (editorWidget) {
-        ColorCategory cat = (d->generalSettings.m_editorSensitive)
-                ? d->colorCategoryForEditor(currentEditor)
-                : ColorCategory::AnyCategory;
+void ColorPickerPlugin::onRecolorProjectTriggered()
+{
+    Project *project = d->currentProject();
 
-        // Create a watcher or apply an existing one to the current texteditor
-        ColorWatcher *watcher = nullptr;
+    if (!project) {
+        MessageManager::write(tr("ColorPicker: no project to recolor."));
+        return;
+    }
 
-        if (!d->watchers.contains(currentEditor)) {
-            watcher = new ColorWatcher(editorWidget);
-            watcher->setColorCategory(cat);
+    // Starts from the color being edited
+    RecolorDialog dialog(ICore::mainWindow());
 
-            d->watchers.insert(currentEditor, watcher);
-        }
-        else {
-            watcher = d->watchers.value(currentEditor);
-        }
+    if (d->colorEditorDialog) {
+        const QColor editedColor = d->colorEditorDialog->colorWidget()->color();
 
-        Q_ASSERT(watcher);
+        dialog.setSourceColors(QVector<QColor>() << editedColor);
+        dialog.setTargetColor(editedColor);
+    }
 
-        // Process the color under cursor
-        ColorExpr toEdit = watcher->process();
+    if (dialog.exec() != QDialog::Accepted)
+        return;
 
-        // Show and move the dialog
-        d->colorEditorDialog->show();
+    QFuture<RecolorProposals> future =
+            d->projectRecolor->start(project->files(Project::SourceFiles),
+                                     dialog.sourceColors(), dialog.targetColor(),
+                                     d->generalSettings.m_replaceTolerance);
 
-        QWidget *editorViewport = editorWidget->viewport();
-        QPoint newPos = d->clampColorEditorPosition(toEdit.pos,
-                                                    editorViewport->rect());
-        d->colorEditorDialog->move(editorViewport->mapToGlobal(newPos));
+    ProgressManager::addTask(QFuture<void>(future),
+                             tr("Looking for colors to replace in %1").arg(project->displayName()),
+                             Constants::TASK_RECOLOR_PROJECT);
+}
 
-        // Update the color dialog to reflect the processed color
-        Q_ASSERT(d->colorEditorDialog);
-        ColorEditor *colorEditor = d->colorEditorDialog->colorWidget();
-        colorEditor->setColorCategory(cat);
+void ColorPickerPlugin::onProjectRecolored(int replacementCount, int fileCount)
+{
+    MessageManager::write(tr("ColorPicker: %1 colors replaced in %2 files.")
+                          .arg(replacementCount)
+                          .arg(fileCount));
+}
 
-        QColor newColor;
+void ColorPickerPlugin::onStartupProjectChanged(Project *project)
+{
+    if (project)
+        d->scanProject(project);
+}
 
-        if (toEdit.value.isValid()) {
-            newColor = toEdit.value;
+void ColorPickerPlugin::onProjectFileListChanged()
+{
+    // Restarted by every change, the project is scanned once it settles
+    if (d->scannedProject)
+        d->rescanTimer.start();
+}
 
-            const QSignalBlocker blocker(colorEditor);
-            colorEditor->setOutputFormat(toEdit.format);
-        } else {
-            newColor = colorEditor->color();
-        }
+void ColorPickerPlugin::onProjectColorsScanned()
+{
+    if (d->scannedProject)
+        d->projectColorScanner->saveIndex(d->indexFileName(d->scannedProject));
 
-        colorEditor->setColor(newColor);
-    }
+    if (!d->reportScan)
+        return;
+
+    d->reportScan = false;
+
+    const ColorInventory &inventory = d->projectColorScanner->inventory();
+
+    MessageManager::write(tr("ColorPicker: %1 distinct colors, %2 occurrences in %3 files, "
+                             "%4 files rescanned (%5 ms).")
+                          .arg(inventory.colors().size())
+                          .arg(inventory.occurrenceCount())
+                          .arg(inventory.fileCount())
+                          .arg(d->projectColorScanner->rescannedFileCount())
+                          .arg(d->scanTimer.elapsed()));
 }
 
 void ColorPickerPlugin::onGeneralSettingsChanged(const GeneralSettings &gs)
@@ -271,6 +786,36 @@ void ColorPickerPlugin::onGeneralSettingsChanged(const GeneralSettings &gs)
         d->insertOnChangeSettingChanged(insertOnChangeNewVal);
     }
 
+    // Setting : preview changes
+    bool previewChangesOldVal = d->generalSettings.m_previewChanges;
+    bool previewChangesNewVal = gs.m_previewChanges;
+
+    if (previewChangesNewVal != previewChangesOldVal) {
+        d->previewChangesSettingChanged(previewChangesNewVal);
+    }
+
+    // Setting : show swatches
+    bool showSwatchesOldVal = d->generalSettings.m_showSwatches;
+    bool showSwatchesNewVal = gs.m_showSwatches;
+
+    if (showSwatchesNewVal != showSwatchesOldVal) {
+        d->showSwatchesSettingChanged(showSwatchesNewVal);
+    }
+
+    // Setting : show tooltips
+    bool showTooltipsOldVal = d->generalSettings.m_showTooltips;
+    bool showTooltipsNewVal = gs.m_showTooltips;
+
+    if (showTooltipsNewVal != showTooltipsOldVal) {
+        d->showTooltipsSettingChanged(showTooltipsNewVal);
+    }
+
+    // Setting : decimals
+    if (gs.m_qmlDecimals != d->generalSettings.m_qmlDecimals
+            || gs.m_glslDecimals != d->generalSettings.m_glslDecimals) {
+        d->decimalsSettingChanged(gs.m_qmlDecimals, gs.m_glslDecimals);
+    }
+
     d->generalSettings = gs;
 }
 
@@ -282,18 +827,25 @@ void ColorPickerPlugin::onColorSelected(const QColor &color,
 
 void ColorPickerPlugin::onColorChanged(const QColor &color)
 {
-    Q_ASSERT(d->colorEditorDialog);
-    ColorEditor *colorEditor = d->colorEditorDialog->colorWidget();
+    TraceSpan span("ColorPickerPlugin::onColorChanged");
+
+    ColorEditor *colorEditor = d->editorDialog()->colorWidget();
 
-    d->colorModifier->insertColor(color, colorEditor->outputFormat());
+    // Emitted on every mouse move of a drag
+    if (d->generalSettings.m_previewChanges)
+        d->colorModifier->previewColor(color, colorEditor->outputFormat());
+    else
+        d->colorModifier->scheduleColor(color, colorEditor->outputFormat());
 }
 
 void ColorPickerPlugin::onOutputFormatChanged(ColorFormat format)
 {
-    Q_ASSERT(d->colorEditorDialog);
-    ColorEditor *colorEditor = d->colorEditorDialog->colorWidget();
+    ColorEditor *colorEditor = d->editorDialog()->colorWidget();
 
-    d->colorModifier->insertColor(colorEditor->color(), format);
+    if (d->generalSettings.m_previewChanges)
+        d->colorModifier->previewColor(colorEditor->color(), format);
+    else
+        d->colorModifier->insertColor(colorEditor->color(), format);
 }
 
 } // namespace Internal
@@ -9,6 +9,10 @@ namespace Core {
 class IEditor;
 }
 
+namespace ProjectExplorer {
+class Project;
+}
+
 namespace ColorPicker {
 namespace Internal {
 
@@ -29,9 +33,17 @@ public:
                             QString *errorMessage);
 
     virtual void extensionsInitialized();
+    virtual bool delayedInitialize();
 
 private slots:
     void onColorEditTriggered();
+    void onReplaceColorTriggered();
+    void onScanProjectColorsTriggered();
+    void onStartupProjectChanged(ProjectExplorer::Project *project);
+    void onProjectFileListChanged();
+    void onProjectColorsScanned();
+    void onRecolorProjectTriggered();
+    void onProjectRecolored(int replacementCount, int fileCount);
     void onGeneralSettingsChanged(const GeneralSettings &gs);
     void onColorSelected(const QColor &color, ColorFormat format);
     void onColorChanged(const QColor &color);
@@ -40,6 +52,22 @@ private slots:
 #if defined(WITH_TESTS)
     // The following tests expect that no projects are loaded on start-up.
     void test_addAndReplaceColor();
+    void test_replaceAllColors();
+    void test_previewColor();
+    void test_pinnedDocument();
+    void test_swatchClick();
+    void test_hoverTooltip();
+    void test_recolorFiles();
+
+    void test_scanColors_data();
+    void test_scanColors();
+    void test_scanColorNames_data();
+    void test_scanColorNames();
+    void test_findMatchAt();
+    void test_findColorCandidates();
+    void test_colorIndex();
+    void test_colorToString_data();
+    void test_colorToString();
 #endif
 
 private:
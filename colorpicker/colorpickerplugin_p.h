@@ -1,14 +1,24 @@
 #ifndef COLORPICKERPLUGIN_P_H
 #define COLORPICKERPLUGIN_P_H
 
+#include <QElapsedTimer>
+#include <QPointer>
+#include <QTimer>
+
 #include "generalsettings.h"
 
+namespace TextEditor {
+class TextEditorWidget;
+}
+
 namespace ColorPicker {
 namespace Internal {
 
 class ColorEditorDialog;
 class ColorModifier;
 class ColorWatcher;
+class ProjectColorScanner;
+class ProjectRecolor;
 
 ////////////////////////// ColorPickerPluginImpl //////////////////////////
 
@@ -24,17 +34,47 @@ public:
                                     const QRect &rect) const;
 
 
+    ProjectExplorer::Project *currentProject() const;
+    QString indexFileName(ProjectExplorer::Project *project) const;
+    void scanProject(ProjectExplorer::Project *project);
+    void releaseScannedProject();
+
+    ColorWatcher *watcherForEditor(Core::IEditor *editor,
+                                   TextEditor::TextEditorWidget *editorWidget);
+    void touchWatcher(Core::IEditor *editor);
+    void forgetWatcher(Core::IEditor *editor);
+    void logWatchers() const;
+    void editColorUnderCursor(Core::IEditor *editor, bool replaceAll);
+
+    ColorEditorDialog *editorDialog();
+
     void setInsertOnChange(bool enable);
 
     void editorSensitiveSettingChanged(bool isSensitive);
     void insertOnChangeSettingChanged(bool insertOnChange);
+    void previewChangesSettingChanged(bool previewChanges);
+    void showSwatchesSettingChanged(bool showSwatches);
+    void showTooltipsSettingChanged(bool showTooltips);
+    void decimalsSettingChanged(int qmlDecimals, int glslDecimals);
 
     /* variables */
     ColorPickerPlugin *q;
 
     QMap<Core::IEditor *, ColorWatcher *> watchers;
+    QList<Core::IEditor *> recentEditors;   // Most recently used first
     ColorModifier *colorModifier;
-    ColorEditorDialog *colorEditorDialog;
+    ColorEditorDialog *colorEditorDialog;     // Created on first use, see editorDialog()
+    ProjectColorScanner *projectColorScanner;
+    ProjectRecolor *projectRecolor;
+    QPointer<ProjectExplorer::Project> scannedProject;
+    QTimer rescanTimer;         // Coalesces the file list changes of the project
+    bool reportScan;
+    QElapsedTimer scanTimer;
+
+    QElapsedTimer startupTimer;
+    qint64 initializeTime;      // ns
+    qint64 extensionsInitializedTime;
+    qint64 dialogPrewarmTime;
 
     GeneralSettings generalSettings;
 };
@@ -0,0 +1,363 @@
+#include "colorprefilter.h"
+
+// Qt includes
+#include <QtAlgorithms>
+
+#if defined(__AVX2__) || defined(__SSE2__)
+#include <immintrin.h>
+#endif
+
+// Plugin includes
+#include "colorpickerconstants.h"
+
+namespace {
+
+using namespace ColorPicker::Internal;
+
+// Lowercase first letters of the grammar keywords. Setting the 0x20 bit of a
+// character folds only 'A'-'Z' onto these letters, so a single comparison
+// handles both cases.
+const ushort CASE_BIT = 0x20;
+
+constexpr bool isCandidateLetter(char c)
+{
+    return (c == 'r') || (c == 'h') || (c == 'q') || (c == 'v');
+}
+
+constexpr bool grammarStartsWithCandidateLetters()
+{
+    for (const Constants::PatternRule &pattern : Constants::COLOR_GRAMMAR) {
+        if (!isCandidateLetter(pattern.keyword[0]))
+            return false;
+    }
+
+    return true;
+}
+
+static_assert(grammarStartsWithCandidateLetters(),
+              "A keyword of the color grammar starts with a letter the prefilter skips");
+
+// Characters of a word (non ASCII ones included) and the prefixes of members,
+// id selectors and variables : a color name cannot follow them
+inline bool blocksName(ushort c)
+{
+    const ushort folded = (c | CASE_BIT);
+
+    return (folded >= 'a' && folded <= 'z') || (c >= '0' && c <= '9') || (c >= 128)
+            || (c == '_') || (c == '-') || (c == '.') || (c == '#') || (c == '$') || (c == '@');
+}
+
+template <typename Char>
+int findCandidateScalar(const Char *data, int from, int to)
+{
+    while (from < to && !isColorCandidate(ushort(data[from])))
+        ++from;
+
+    return from;
+}
+
+template <typename Char>
+int findColorOrNameCandidateScalar(const Char *data, int begin, int from, int to)
+{
+    ushort before = (from > begin) ? ushort(data[from - 1]) : 0;
+
+    for (; from < to; ++from) {
+        const ushort c = ushort(data[from]);
+
+        if (isColorCandidate(c) || isNameCandidate(before, c))
+            return from;
+
+        before = c;
+    }
+
+    return to;
+}
+
+#if defined(__AVX2__)
+
+const int UTF16_STEP = 16;
+const int LATIN1_STEP = 32;
+
+// Byte mask of the candidates among 16 UTF-16 characters (2 bits each)
+inline uint candidateMask16(const ushort *data)
+{
+    const __m256i chars = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(data));
+    const __m256i folded = _mm256_or_si256(chars, _mm256_set1_epi16(CASE_BIT));
+
+    __m256i ret = _mm256_cmpeq_epi16(chars, _mm256_set1_epi16('#'));
+    ret = _mm256_or_si256(ret, _mm256_cmpeq_epi16(folded, _mm256_set1_epi16('r')));
+    ret = _mm256_or_si256(ret, _mm256_cmpeq_epi16(folded, _mm256_set1_epi16('h')));
+    ret = _mm256_or_si256(ret, _mm256_cmpeq_epi16(folded, _mm256_set1_epi16('q')));
+    ret = _mm256_or_si256(ret, _mm256_cmpeq_epi16(folded, _mm256_set1_epi16('v')));
+
+    return uint(_mm256_movemask_epi8(ret));
+}
+
+// Byte masks of the ASCII letters and of the characters blocking a name
+// (see blocksName()) among 16 UTF-16 characters (2 bits each)
+inline void nameMasks16(const ushort *data, uint *letters, uint *blockers)
+{
+    const __m256i chars = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(data));
+    const __m256i folded = _mm256_or_si256(chars, _mm256_set1_epi16(CASE_BIT));
+
+    // Signed comparisons, the characters above 0x7FFF being negative
+    const __m256i letter = _mm256_and_si256(_mm256_cmpgt_epi16(folded, _mm256_set1_epi16('a' - 1)),
+                                            _mm256_cmpgt_epi16(_mm256_set1_epi16('z' + 1), folded));
+    const __m256i digit = _mm256_and_si256(_mm256_cmpgt_epi16(chars, _mm256_set1_epi16('0' - 1)),
+                                           _mm256_cmpgt_epi16(_mm256_set1_epi16('9' + 1), chars));
+    const __m256i ascii = _mm256_cmpeq_epi16(_mm256_and_si256(chars, _mm256_set1_epi16(short(0xFF80))),
+                                             _mm256_setzero_si256());
+
+    __m256i blocked = _mm256_or_si256(letter, digit);
+    blocked = _mm256_or_si256(blocked, _mm256_xor_si256(ascii, _mm256_set1_epi16(-1)));
+    blocked = _mm256_or_si256(blocked, _mm256_cmpeq_epi16(chars, _mm256_set1_epi16('_')));
+    blocked = _mm256_or_si256(blocked, _mm256_cmpeq_epi16(chars, _mm256_set1_epi16('-')));
+    blocked = _mm256_or_si256(blocked, _mm256_cmpeq_epi16(chars, _mm256_set1_epi16('.')));
+    blocked = _mm256_or_si256(blocked, _mm256_cmpeq_epi16(chars, _mm256_set1_epi16('#')));
+    blocked = _mm256_or_si256(blocked, _mm256_cmpeq_epi16(chars, _mm256_set1_epi16('$')));
+    blocked = _mm256_or_si256(blocked, _mm256_cmpeq_epi16(chars, _mm256_set1_epi16('@')));
+
+    *letters = uint(_mm256_movemask_epi8(letter));
+    *blockers = uint(_mm256_movemask_epi8(blocked));
+}
+
+// Byte mask of the candidates among 32 8 bits characters
+inline uint candidateMask8(const char *data)
+{
+    const __m256i chars = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(data));
+    const __m256i folded = _mm256_or_si256(chars, _mm256_set1_epi8(char(CASE_BIT)));
+
+    __m256i ret = _mm256_cmpeq_epi8(chars, _mm256_set1_epi8('#'));
+    ret = _mm256_or_si256(ret, _mm256_cmpeq_epi8(folded, _mm256_set1_epi8('r')));
+    ret = _mm256_or_si256(ret, _mm256_cmpeq_epi8(folded, _mm256_set1_epi8('h')));
+    ret = _mm256_or_si256(ret, _mm256_cmpeq_epi8(folded, _mm256_set1_epi8('q')));
+    ret = _mm256_or_si256(ret, _mm256_cmpeq_epi8(folded, _mm256_set1_epi8('v')));
+
+    return uint(_mm256_movemask_epi8(ret));
+}
+
+// Same as nameMasks16() among 32 8 bits characters (1 bit each)
+inline void nameMasks8(const char *data, uint *letters, uint *blockers)
+{
+    const __m256i chars = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(data));
+    const __m256i folded = _mm256_or_si256(chars, _mm256_set1_epi8(char(CASE_BIT)));
+
+    // Signed comparisons, the characters above 0x7F being negative
+    const __m256i letter = _mm256_and_si256(_mm256_cmpgt_epi8(folded, _mm256_set1_epi8('a' - 1)),
+                                            _mm256_cmpgt_epi8(_mm256_set1_epi8('z' + 1), folded));
+    const __m256i digit = _mm256_and_si256(_mm256_cmpgt_epi8(chars, _mm256_set1_epi8('0' - 1)),
+                                           _mm256_cmpgt_epi8(_mm256_set1_epi8('9' + 1), chars));
+    const __m256i nonAscii = _mm256_cmpgt_epi8(_mm256_setzero_si256(), chars);
+
+    __m256i blocked = _mm256_or_si256(letter, digit);
+    blocked = _mm256_or_si256(blocked, nonAscii);
+    blocked = _mm256_or_si256(blocked, _mm256_cmpeq_epi8(chars, _mm256_set1_epi8('_')));
+    blocked = _mm256_or_si256(blocked, _mm256_cmpeq_epi8(chars, _mm256_set1_epi8('-')));
+    blocked = _mm256_or_si256(blocked, _mm256_cmpeq_epi8(chars, _mm256_set1_epi8('.')));
+    blocked = _mm256_or_si256(blocked, _mm256_cmpeq_epi8(chars, _mm256_set1_epi8('#')));
+    blocked = _mm256_or_si256(blocked, _mm256_cmpeq_epi8(chars, _mm256_set1_epi8('$')));
+    blocked = _mm256_or_si256(blocked, _mm256_cmpeq_epi8(chars, _mm256_set1_epi8('@')));
+
+    *letters = uint(_mm256_movemask_epi8(letter));
+    *blockers = uint(_mm256_movemask_epi8(blocked));
+}
+
+#elif defined(__SSE2__)
+
+const int UTF16_STEP = 8;
+const int LATIN1_STEP = 16;
+
+// Byte mask of the candidates among 8 UTF-16 characters (2 bits each)
+inline uint candidateMask16(const ushort *data)
+{
+    const __m128i chars = _mm_loadu_si128(reinterpret_cast<const __m128i *>(data));
+    const __m128i folded = _mm_or_si128(chars, _mm_set1_epi16(CASE_BIT));
+
+    __m128i ret = _mm_cmpeq_epi16(chars, _mm_set1_epi16('#'));
+    ret = _mm_or_si128(ret, _mm_cmpeq_epi16(folded, _mm_set1_epi16('r')));
+    ret = _mm_or_si128(ret, _mm_cmpeq_epi16(folded, _mm_set1_epi16('h')));
+    ret = _mm_or_si128(ret, _mm_cmpeq_epi16(folded, _mm_set1_epi16('q')));
+    ret = _mm_or_si128(ret, _mm_cmpeq_epi16(folded, _mm_set1_epi16('v')));
+
+    return uint(_mm_movemask_epi8(ret));
+}
+
+// Byte masks of the ASCII letters and of the characters blocking a name
+// (see blocksName()) among 8 UTF-16 characters (2 bits each)
+inline void nameMasks16(const ushort *data, uint *letters, uint *blockers)
+{
+    const __m128i chars = _mm_loadu_si128(reinterpret_cast<const __m128i *>(data));
+    const __m128i folded = _mm_or_si128(chars, _mm_set1_epi16(CASE_BIT));
+
+    // Signed comparisons, the characters above 0x7FFF being negative
+    const __m128i letter = _mm_and_si128(_mm_cmpgt_epi16(folded, _mm_set1_epi16('a' - 1)),
+                                         _mm_cmplt_epi16(folded, _mm_set1_epi16('z' + 1)));
+    const __m128i digit = _mm_and_si128(_mm_cmpgt_epi16(chars, _mm_set1_epi16('0' - 1)),
+                                        _mm_cmplt_epi16(chars, _mm_set1_epi16('9' + 1)));
+    const __m128i ascii = _mm_cmpeq_epi16(_mm_and_si128(chars, _mm_set1_epi16(short(0xFF80))),
+                                          _mm_setzero_si128());
+
+    __m128i blocked = _mm_or_si128(letter, digit);
+    blocked = _mm_or_si128(blocked, _mm_xor_si128(ascii, _mm_set1_epi16(-1)));
+    blocked = _mm_or_si128(blocked, _mm_cmpeq_epi16(chars, _mm_set1_epi16('_')));
+    blocked = _mm_or_si128(blocked, _mm_cmpeq_epi16(chars, _mm_set1_epi16('-')));
+    blocked = _mm_or_si128(blocked, _mm_cmpeq_epi16(chars, _mm_set1_epi16('.')));
+    blocked = _mm_or_si128(blocked, _mm_cmpeq_epi16(chars, _mm_set1_epi16('#')));
+    blocked = _mm_or_si128(blocked, _mm_cmpeq_epi16(chars, _mm_set1_epi16('$')));
+    blocked = _mm_or_si128(blocked, _mm_cmpeq_epi16(chars, _mm_set1_epi16('@')));
+
+    *letters = uint(_mm_movemask_epi8(letter));
+    *blockers = uint(_mm_movemask_epi8(blocked));
+}
+
+// Byte mask of the candidates among 16 8 bits characters
+inline uint candidateMask8(const char *data)
+{
+    const __m128i chars = _mm_loadu_si128(reinterpret_cast<const __m128i *>(data));
+    const __m128i folded = _mm_or_si128(chars, _mm_set1_epi8(char(CASE_BIT)));
+
+    __m128i ret = _mm_cmpeq_epi8(chars, _mm_set1_epi8('#'));
+    ret = _mm_or_si128(ret, _mm_cmpeq_epi8(folded, _mm_set1_epi8('r')));
+    ret = _mm_or_si128(ret, _mm_cmpeq_epi8(folded, _mm_set1_epi8('h')));
+    ret = _mm_or_si128(ret, _mm_cmpeq_epi8(folded, _mm_set1_epi8('q')));
+    ret = _mm_or_si128(ret, _mm_cmpeq_epi8(folded, _mm_set1_epi8('v')));
+
+    return uint(_mm_movemask_epi8(ret));
+}
+
+// Same as nameMasks16() among 16 8 bits characters (1 bit each)
+inline void nameMasks8(const char *data, uint *letters, uint *blockers)
+{
+    const __m128i chars = _mm_loadu_si128(reinterpret_cast<const __m128i *>(data));
+    const __m128i folded = _mm_or_si128(chars, _mm_set1_epi8(char(CASE_BIT)));
+
+    // Signed comparisons, the characters above 0x7F being negative
+    const __m128i letter = _mm_and_si128(_mm_cmpgt_epi8(folded, _mm_set1_epi8('a' - 1)),
+                                         _mm_cmplt_epi8(folded, _mm_set1_epi8('z' + 1)));
+    const __m128i digit = _mm_and_si128(_mm_cmpgt_epi8(chars, _mm_set1_epi8('0' - 1)),
+                                        _mm_cmplt_epi8(chars, _mm_set1_epi8('9' + 1)));
+    const __m128i nonAscii = _mm_cmplt_epi8(chars, _mm_setzero_si128());
+
+    __m128i blocked = _mm_or_si128(letter, digit);
+    blocked = _mm_or_si128(blocked, nonAscii);
+    blocked = _mm_or_si128(blocked, _mm_cmpeq_epi8(chars, _mm_set1_epi8('_')));
+    blocked = _mm_or_si128(blocked, _mm_cmpeq_epi8(chars, _mm_set1_epi8('-')));
+    blocked = _mm_or_si128(blocked, _mm_cmpeq_epi8(chars, _mm_set1_epi8('.')));
+    blocked = _mm_or_si128(blocked, _mm_cmpeq_epi8(chars, _mm_set1_epi8('#')));
+    blocked = _mm_or_si128(blocked, _mm_cmpeq_epi8(chars, _mm_set1_epi8('$')));
+    blocked = _mm_or_si128(blocked, _mm_cmpeq_epi8(chars, _mm_set1_epi8('@')));
+
+    *letters = uint(_mm_movemask_epi8(letter));
+    *blockers = uint(_mm_movemask_epi8(blocked));
+}
+
+#endif
+
+} // anon namespace
+
+namespace ColorPicker {
+namespace Internal {
+
+bool isColorCandidate(ushort c)
+{
+    if (c == '#')
+        return true;
+
+    const ushort folded = (c | CASE_BIT);
+
+    return (folded == 'r') || (folded == 'h') || (folded == 'q') || (folded == 'v');
+}
+
+int findColorCandidate(const QChar *data, int from, int to)
+{
+    auto chars = reinterpret_cast<const ushort *>(data);
+
+#if defined(__AVX2__) || defined(__SSE2__)
+    for (; from + UTF16_STEP <= to; from += UTF16_STEP) {
+        const uint mask = candidateMask16(chars + from);
+
+        if (mask)
+            return from + int(qCountTrailingZeroBits(mask) / 2);
+    }
+#endif
+
+    return findCandidateScalar(chars, from, to);
+}
+
+int findColorCandidate(const char *data, int from, int to)
+{
+    auto chars = reinterpret_cast<const uchar *>(data);
+
+#if defined(__AVX2__) || defined(__SSE2__)
+    for (; from + LATIN1_STEP <= to; from += LATIN1_STEP) {
+        const uint mask = candidateMask8(data + from);
+
+        if (mask)
+            return from + int(qCountTrailingZeroBits(mask));
+    }
+#endif
+
+    return findCandidateScalar(chars, from, to);
+}
+
+bool isNameCandidate(ushort before, ushort c)
+{
+    const ushort folded = (c | CASE_BIT);
+
+    return (folded >= 'a' && folded <= 'z') && !blocksName(before);
+}
+
+int findColorOrNameCandidate(const QChar *data, int begin, int from, int to)
+{
+    auto chars = reinterpret_cast<const ushort *>(data);
+
+#if defined(__AVX2__) || defined(__SSE2__)
+    // A name starts at a letter whose previous character does not block it.
+    // The blockers are shifted onto the next character, 2 bits per character,
+    // the last one of a step being carried to the next step.
+    uint carry = (from > begin && blocksName(chars[from - 1])) ? 3u : 0u;
+
+    for (; from + UTF16_STEP <= to; from += UTF16_STEP) {
+        uint letters;
+        uint blockers;
+        nameMasks16(chars + from, &letters, &blockers);
+
+        const uint mask = candidateMask16(chars + from) | (letters & ~((blockers << 2) | carry));
+
+        if (mask)
+            return from + int(qCountTrailingZeroBits(mask) / 2);
+
+        carry = (blockers >> (2 * UTF16_STEP - 2)) & 3u;
+    }
+#endif
+
+    return findColorOrNameCandidateScalar(chars, begin, from, to);
+}
+
+int findColorOrNameCandidate(const char *data, int begin, int from, int to)
+{
+    auto chars = reinterpret_cast<const uchar *>(data);
+
+#if defined(__AVX2__) || defined(__SSE2__)
+    // Same as above, 1 bit per character
+    uint carry = (from > begin && blocksName(chars[from - 1])) ? 1u : 0u;
+
+    for (; from + LATIN1_STEP <= to; from += LATIN1_STEP) {
+        uint letters;
+        uint blockers;
+        nameMasks8(data + from, &letters, &blockers);
+
+        const uint mask = candidateMask8(data + from) | (letters & ~((blockers << 1) | carry));
+
+        if (mask)
+            return from + int(qCountTrailingZeroBits(mask));
+
+        carry = (blockers >> (LATIN1_STEP - 1)) & 1u;
+    }
+#endif
+
+    return findColorOrNameCandidateScalar(chars, begin, from, to);
+}
+
+} // namespace Internal
+} // namespace ColorPicker
@@ -0,0 +1,32 @@
+#ifndef COLORPREFILTER_H
+#define COLORPREFILTER_H
+
+#include <QChar>
+
+namespace ColorPicker {
+namespace Internal {
+
+// Whether a color expression may start with this character : '#' or the first
+// letter of a keyword of the grammar, in any case.
+bool isColorCandidate(ushort c);
+
+// Returns the position of the first candidate in [from, to), or 'to' if there
+// is none. Uses AVX2 or SSE2 when the build targets them, the results being
+// the same as testing every character with isColorCandidate().
+int findColorCandidate(const QChar *data, int from, int to);
+int findColorCandidate(const char *data, int from, int to);
+
+// Whether a color name may start at c, preceded by 'before' (0 at the start of
+// the text) : an ASCII letter starting a word that is not a member, an id
+// selector or a variable (".red", "#red", "$red", "@red").
+bool isNameCandidate(ushort before, ushort c);
+
+// Same as findColorCandidate(), the name candidates included. 'begin' is the
+// start of the text, the character before 'from' is looked at when it is in.
+int findColorOrNameCandidate(const QChar *data, int begin, int from, int to);
+int findColorOrNameCandidate(const char *data, int begin, int from, int to);
+
+} // namespace Internal
+} // namespace ColorPicker
+
+#endif // COLORPREFILTER_H
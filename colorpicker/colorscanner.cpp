@@ -0,0 +1,570 @@
+#include "colorscanner.h"
+
+// std includes
+#include <algorithm>
+
+// Plugin includes
+#include "colornames.h"
+#include "colorpickerconstants.h"
+#include "colorprefilter.h"
+
+namespace {
+
+using namespace ColorPicker::Internal;
+
+
+////////////////////// Keyword DFA //////////////////////
+
+// Deterministic automaton recognizing the keywords of Constants::COLOR_GRAMMAR,
+// built at compile time. Each accepting state holds the set of patterns that
+// start with the keyword read so far, as a bitmask of COLOR_GRAMMAR indices.
+struct KeywordDfa
+{
+    enum
+    {
+        MaxStates = 48,
+        MaxClasses = 24,
+        DeadState = 0,
+        StartState = 1
+    };
+
+    unsigned char charClass[128];   // 0 for characters not used in any keyword
+    unsigned char next[MaxStates][MaxClasses];
+    quint32 accepted[MaxStates];
+    int stateCount;
+    int classCount;
+};
+
+constexpr char toLowerAscii(char c)
+{
+    return (c >= 'A' && c <= 'Z') ? char(c | 0x20) : c;
+}
+
+constexpr KeywordDfa buildKeywordDfa()
+{
+    KeywordDfa dfa = {};
+    dfa.stateCount = KeywordDfa::StartState + 1;
+    dfa.classCount = 1;
+
+    for (int p = 0; p < Constants::COLOR_GRAMMAR_SIZE; ++p) {
+        int state = KeywordDfa::StartState;
+
+        for (const char *it = Constants::COLOR_GRAMMAR[p].keyword; *it; ++it) {
+            const char lower = toLowerAscii(*it);
+
+            if (!dfa.charClass[int(lower)]) {
+                const int newClass = dfa.classCount++;
+                dfa.charClass[int(lower)] = newClass;
+
+                if (lower >= 'a' && lower <= 'z')
+                    dfa.charClass[int(lower) - 0x20] = newClass;
+            }
+
+            const int cls = dfa.charClass[int(lower)];
+
+            if (!dfa.next[state][cls])
+                dfa.next[state][cls] = dfa.stateCount++;
+
+            state = dfa.next[state][cls];
+        }
+
+        dfa.accepted[state] |= (1u << p);
+    }
+
+    return dfa;
+}
+
+constexpr KeywordDfa keywordDfa = buildKeywordDfa();
+
+static_assert(Constants::COLOR_GRAMMAR_SIZE <= 32,
+              "The pattern sets are stored in 32 bits");
+static_assert(keywordDfa.stateCount <= KeywordDfa::MaxStates,
+              "KeywordDfa::MaxStates is too small for the color grammar");
+static_assert(keywordDfa.classCount <= KeywordDfa::MaxClasses,
+              "KeywordDfa::MaxClasses is too small for the color grammar");
+
+
+////////////////////// Scanning Helpers //////////////////////
+
+inline ushort unicodeOf(QChar c)
+{
+    return c.unicode();
+}
+
+inline ushort unicodeOf(char c)
+{
+    return uchar(c);
+}
+
+inline bool isBlank(ushort c)
+{
+    return (c == ' ') || (c >= '\t' && c <= '\r');
+}
+
+inline bool isDigit(ushort c)
+{
+    return (c >= '0' && c <= '9');
+}
+
+inline bool isHexDigit(ushort c)
+{
+    return isDigit(c) || (c >= 'a' && c <= 'f');
+}
+
+inline bool isAsciiLetter(ushort c)
+{
+    c |= 0x20;
+
+    return (c >= 'a' && c <= 'z');
+}
+
+// Characters of an identifier, non ASCII ones included
+inline bool isWordChar(ushort c)
+{
+    return isAsciiLetter(c) || isDigit(c) || (c == '_') || (c == '-') || (c >= 128);
+}
+
+// Reads UTF-16 text (QChar) or 8 bits text (char), the grammar being ASCII
+template <typename Char>
+class TextReader
+{
+public:
+    TextReader(const Char *data, int size, int pos) :
+        m_data(data),
+        m_size(size),
+        m_pos(pos)
+    {}
+
+    int pos() const
+    {
+        return m_pos;
+    }
+
+    // Returns the lowercase character at the current position, 0 at the end
+    ushort peek() const
+    {
+        if (m_pos >= m_size)
+            return 0;
+
+        ushort c = unicodeOf(m_data[m_pos]);
+
+        return (c >= 'A' && c <= 'Z') ? ushort(c | 0x20) : c;
+    }
+
+    void advance()
+    {
+        ++m_pos;
+    }
+
+    bool accept(ushort c)
+    {
+        if (peek() != c)
+            return false;
+
+        ++m_pos;
+        return true;
+    }
+
+    void skipBlanks()
+    {
+        while (isBlank(peek()))
+            ++m_pos;
+    }
+
+private:
+    const Char *m_data;
+    int m_size;
+    int m_pos;
+};
+
+// Reads the longest keyword at the current position and returns the set of
+// patterns it introduces
+template <typename Char>
+quint32 readKeyword(TextReader<Char> &reader)
+{
+    int state = KeywordDfa::StartState;
+
+    forever {
+        const ushort c = reader.peek();
+        if (c >= 128)
+            break;
+
+        const int nextState = keywordDfa.next[state][keywordDfa.charClass[c]];
+        if (nextState == KeywordDfa::DeadState)
+            break;
+
+        state = nextState;
+        reader.advance();
+    }
+
+    return keywordDfa.accepted[state];
+}
+
+// [0-9]*(\.[0-9]*)?\%?, read once and checked against the rule of every
+// pattern still alive
+struct NumberToken
+{
+    int start;
+    int length;                 // The percent sign excluded
+    int integerDigitCount;
+    int integerValue;           // Only meaningful up to 3 digits
+    bool leadingZero;
+    bool integerIsZeros;        // No digit other than '0' before the dot
+    bool hasDot;
+    int fractionDigitCount;
+    bool fractionIsZeros;
+    bool hasPercentSign;
+};
+
+template <typename Char>
+NumberToken readNumber(TextReader<Char> &reader)
+{
+    NumberToken ret = { reader.pos(), 0, 0, 0, false, true, false, 0, true, false };
+
+    ret.leadingZero = (reader.peek() == '0');
+
+    while (isDigit(reader.peek())) {
+        const int digit = reader.peek() - '0';
+
+        if (++ret.integerDigitCount <= 3)
+            ret.integerValue = ret.integerValue * 10 + digit;
+
+        ret.integerIsZeros = ret.integerIsZeros && !digit;
+        reader.advance();
+    }
+
+    if (reader.accept('.')) {
+        ret.hasDot = true;
+
+        while (isDigit(reader.peek())) {
+            ++ret.fractionDigitCount;
+            ret.fractionIsZeros = ret.fractionIsZeros && (reader.peek() == '0');
+            reader.advance();
+        }
+    }
+
+    ret.length = reader.pos() - ret.start;
+    ret.hasPercentSign = reader.accept('%');
+
+    return ret;
+}
+
+bool componentAccepts(const Constants::ComponentRule &rule, const NumberToken &token)
+{
+    if (token.hasPercentSign && !rule.percentSign)
+        return false;
+
+    // 0, 1, 1.0 or 0*.[0-9]+
+    if (rule.maxInteger < 0) {
+        if (!token.hasDot)
+            return (token.integerDigitCount == 1) && (token.integerValue <= 1);
+
+        if (token.integerIsZeros)
+            return (token.fractionDigitCount > 0);
+
+        return (token.integerDigitCount == 1) && (token.integerValue == 1)
+                && (token.fractionDigitCount == 1) && token.fractionIsZeros;
+    }
+
+    // Integer without leading zeros
+    if (token.hasDot || !token.integerDigitCount || token.integerDigitCount > 3)
+        return false;
+
+    if (token.integerDigitCount > 1 && token.leadingZero)
+        return false;
+
+    return (token.integerValue <= rule.maxInteger);
+}
+
+// Runs all the candidate patterns at once : every token is read a single time
+// and the set of patterns still alive shrinks as the tokens are checked.
+template <typename Char>
+bool matchPatterns(quint32 candidates, TextReader<Char> reader, ColorMatch *match)
+{
+    const int start = reader.pos();
+
+    candidates &= readKeyword(reader);
+    if (!candidates)
+        return false;
+
+    reader.skipBlanks();
+
+    if (!reader.accept('('))
+        return false;
+
+    for (int i = 0; candidates && i < 4; ++i) {
+        // Longer expressions are out of the grammar
+        if (reader.pos() - start > Constants::GRAMMAR_MAX_EXPRESSION_LENGTH)
+            return false;
+
+        reader.skipBlanks();
+
+        const NumberToken token = readNumber(reader);
+        match->capturedStart[i] = token.start;
+        match->capturedLength[i] = token.length;
+
+        quint32 complete = 0;
+
+        for (int p = 0; p < Constants::COLOR_GRAMMAR_SIZE; ++p) {
+            const quint32 bit = (1u << p);
+            if (!(candidates & bit))
+                continue;
+
+            const Constants::PatternRule &pattern = Constants::COLOR_GRAMMAR[p];
+
+            if (!componentAccepts(pattern.components[i], token))
+                candidates &= ~bit;
+            else if (pattern.componentCount == i + 1)
+                complete |= bit;
+        }
+
+        reader.skipBlanks();
+
+        if (reader.accept(')')) {
+            candidates &= complete;
+
+            if (!candidates || reader.pos() - start > Constants::GRAMMAR_MAX_EXPRESSION_LENGTH)
+                return false;
+
+            // The lowest index has the highest priority
+            int p = 0;
+            while (!(candidates & (1u << p)))
+                ++p;
+
+            match->format = Constants::COLOR_GRAMMAR[p].format;
+            match->start = start;
+            match->length = reader.pos() - start;
+            match->capturedCount = i + 1;
+
+            return true;
+        }
+
+        if (!reader.accept(','))
+            return false;
+
+        candidates &= ~complete;
+    }
+
+    return false;
+}
+
+// #FFFFFFFFFFFF | #FFFFFFFFF | #FFFFFFFF | #FFFFFF | #FFF
+template <typename Char>
+bool matchHexColor(TextReader<Char> reader, ColorMatch *match)
+{
+    const int start = reader.pos();
+
+    if (!reader.accept('#'))
+        return false;
+
+    int digitCount = 0;
+
+    while (digitCount < Constants::GRAMMAR_HEX_DIGIT_COUNTS[0]
+           && isHexDigit(reader.peek())) {
+        reader.advance();
+        ++digitCount;
+    }
+
+    for (int allowed : Constants::GRAMMAR_HEX_DIGIT_COUNTS) {
+        if (digitCount >= allowed) {
+            match->format = HexFormat;
+            match->start = start;
+            match->length = allowed + 1;
+            match->capturedCount = 0;
+
+            return true;
+        }
+    }
+
+    return false;
+}
+
+// A whole word among the named colors, not followed by '(' (a function call)
+template <typename Char>
+bool matchColorName(TextReader<Char> reader, ColorMatch *match)
+{
+    const int start = reader.pos();
+
+    char name[COLOR_NAME_MAX_LENGTH];
+    int length = 0;
+
+    // Ordinary identifiers are dropped as soon as they are too long
+    while (isAsciiLetter(reader.peek())) {
+        if (length == COLOR_NAME_MAX_LENGTH)
+            return false;
+
+        name[length++] = char(reader.peek());
+        reader.advance();
+    }
+
+    const ushort after = reader.peek();
+
+    if (isWordChar(after) || after == '(')
+        return false;
+
+    QRgb value;
+
+    if (!findNamedColor(name, length, &value))
+        return false;
+
+    match->format = NamedColorFormat;
+    match->start = start;
+    match->length = length;
+    match->capturedCount = 0;
+
+    return true;
+}
+
+// The text before 'begin' is hidden from the matcher, like the text after 'size'
+template <typename Char>
+bool matchText(ColorFormatSet formats, quint32 patternMask, const Char *data, int begin, int size,
+               int pos, ColorMatch *match)
+{
+    Q_ASSERT(match);
+
+    TextReader<Char> reader(data, size, pos);
+
+    const ushort c = reader.peek();
+
+    if (c == '#')
+        return formats.contains(HexFormat) && matchHexColor(reader, match);
+
+    if (isColorCandidate(c) && matchPatterns(patternMask, reader, match))
+        return true;
+
+    if (!formats.contains(NamedColorFormat))
+        return false;
+
+    const ushort before = (pos > begin) ? unicodeOf(data[pos - 1]) : 0;
+
+    return isNameCandidate(before, c) && matchColorName(reader, match);
+}
+
+template <typename Char>
+ColorMatchList scanText(ColorFormatSet formats, quint32 patternMask, const Char *data, int from,
+                        int to)
+{
+    ColorMatchList ret;
+
+    // Names start at any word, which the prefilter looks for only when needed
+    const bool findNames = formats.contains(NamedColorFormat);
+
+    auto nextCandidate = [=](int pos) {
+        return (findNames) ? findColorOrNameCandidate(data, from, pos, to)
+                           : findColorCandidate(data, pos, to);
+    };
+
+    // Only the characters that can start an expression are handed to the matcher
+    int pos = nextCandidate(from);
+
+    while (pos < to) {
+        ColorMatch match;
+
+        // The text outside [from, to) is hidden from the matcher
+        if (matchText(formats, patternMask, data, from, to, pos, &match)) {
+            ret.append(match);
+            pos = nextCandidate(match.end());
+        } else {
+            pos = nextCandidate(pos + 1);
+        }
+    }
+
+    return ret;
+}
+
+} // anon namespace
+
+namespace ColorPicker {
+namespace Internal {
+
+ColorScanner::ColorScanner(const ColorFormatSet &formats) :
+    m_formats(),
+    m_patternMask(0)
+{
+    setFormats(formats);
+}
+
+ColorFormatSet ColorScanner::formats() const
+{
+    return m_formats;
+}
+
+void ColorScanner::setFormats(const ColorFormatSet &formats)
+{
+    m_formats = formats;
+    m_patternMask = 0;
+
+    for (int p = 0; p < Constants::COLOR_GRAMMAR_SIZE; ++p) {
+        if (formats.contains(Constants::COLOR_GRAMMAR[p].format))
+            m_patternMask |= (1u << p);
+    }
+}
+
+ColorMatchList ColorScanner::scan(const QString &text) const
+{
+    return scan(text, 0, text.size());
+}
+
+ColorMatchList ColorScanner::scan(const QString &text, int from, int to) const
+{
+    Q_ASSERT(from >= 0 && to <= text.size());
+
+    return scanText(m_formats, m_patternMask, text.constData(), from, to);
+}
+
+ColorMatchList ColorScanner::scan(const char *data, int from, int to) const
+{
+    Q_ASSERT(from >= 0 && from <= to);
+
+    return scanText(m_formats, m_patternMask, data, from, to);
+}
+
+bool ColorScanner::matchAt(const QString &text, int pos, ColorMatch *match) const
+{
+    return matchText(m_formats, m_patternMask, text.constData(), 0, text.size(), pos, match);
+}
+
+bool ColorScanner::matchAround(const QString &text, int pos, ColorMatch *match) const
+{
+    Q_ASSERT(match);
+
+    const int size = text.size();
+    int start = qMax(0, pos - Constants::GRAMMAR_MAX_EXPRESSION_LENGTH);
+
+    // Gives up as soon as no expression can start before pos
+    while (start <= pos && start < size) {
+        if (matchAt(text, start, match)) {
+            if (match->end() >= pos)
+                return true;
+
+            start = match->end();
+        } else {
+            ++start;
+        }
+    }
+
+    return false;
+}
+
+int findMatchAt(const ColorMatchList &matches, int pos)
+{
+    auto startsAfter = [](int p, const ColorMatch &match) {
+        return p < match.start;
+    };
+
+    // Last match starting at or before pos
+    auto it = std::upper_bound(matches.cbegin(), matches.cend(), pos, startsAfter);
+    if (it == matches.cbegin())
+        return -1;
+
+    int ret = int(it - matches.cbegin()) - 1;
+
+    // When two matches touch, the cursor belongs to the first one
+    if (ret > 0 && matches.at(ret - 1).end() >= pos)
+        --ret;
+
+    return (matches.at(ret).end() >= pos) ? ret : -1;
+}
+
+} // namespace Internal
+} // namespace ColorPicker
@@ -0,0 +1,44 @@
+#ifndef COLORSCANNER_H
+#define COLORSCANNER_H
+
+#include "colorutilities.h"
+
+namespace ColorPicker {
+namespace Internal {
+
+class ColorScanner
+{
+public:
+    explicit ColorScanner(const ColorFormatSet &formats = formatsFromCategory(AnyCategory));
+
+    ColorFormatSet formats() const;
+    void setFormats(const ColorFormatSet &formats);
+
+    // Finds every color expression of the text in a single left-to-right walk.
+    // The matches are sorted and never overlap.
+    ColorMatchList scan(const QString &text) const;
+    ColorMatchList scan(const QString &text, int from, int to) const;
+
+    // Same on 8 bits text (Latin-1, UTF-8...), positions are byte offsets
+    ColorMatchList scan(const char *data, int from, int to) const;
+
+    // Tries to match a color expression starting exactly at pos.
+    bool matchAt(const QString &text, int pos, ColorMatch *match) const;
+
+    // Finds the expression covering pos, looking only at the characters that
+    // are at most GRAMMAR_MAX_EXPRESSION_LENGTH before it.
+    bool matchAround(const QString &text, int pos, ColorMatch *match) const;
+
+private:
+    ColorFormatSet m_formats;
+    quint32 m_patternMask;
+};
+
+// Index of the match covering pos (its bounds included) in a sorted list of
+// non-overlapping matches, found by binary search. -1 if there is none.
+int findMatchAt(const ColorMatchList &matches, int pos);
+
+} // namespace Internal
+} // namespace ColorPicker
+
+#endif // COLORSCANNER_H
@@ -0,0 +1,272 @@
+#include "colorpickerplugin.h"
+
+// Qt includes
+#include <QTextCursor>
+#include <QTextDocument>
+#include <QtTest>
+
+// Plugin includes
+#include "colorindex.h"
+#include "colorprefilter.h"
+#include "colorscanner.h"
+
+namespace ColorPicker {
+namespace Internal {
+
+void ColorPickerPlugin::test_scanColors_data()
+{
+    QTest::addColumn<QString>("text");
+    QTest::addColumn<int>("start");
+    QTest::addColumn<int>("length");
+    QTest::addColumn<int>("format");
+    QTest::addColumn<QColor>("color");
+
+    QTest::newRow("rgb") << QString::fromLatin1("color: rgb(12, 20, 40);")
+                         << 7 << 15 << int(QCssRgbUCharFormat) << QColor(12, 20, 40);
+    QTest::newRow("rgba") << QString::fromLatin1("rgba( 255 ,0,0 , 0.5 )")
+                          << 0 << 22 << int(QCssRgbUCharFormat) << QColor(255, 0, 0, 128);
+    QTest::newRow("rgb percent") << QString::fromLatin1("RGB(100%, 0%, 0%)")
+                                 << 0 << 17 << int(QCssRgbPercentFormat) << QColor(255, 0, 0);
+    QTest::newRow("hsv") << QString::fromLatin1("x: hsv(0, 255, 255)")
+                         << 3 << 16 << int(QssHsvFormat) << QColor::fromHsv(0, 255, 255);
+    QTest::newRow("hsl") << QString::fromLatin1("hsl(120, 100%, 50%)")
+                         << 0 << 19 << int(CssHslFormat) << QColor::fromHsl(120, 255, 127);
+    QTest::newRow("qml") << QString::fromLatin1("color: Qt.rgba(1.0, 0, .5, 1)")
+                         << 7 << 22 << int(QmlRgbaFormat) << QColor::fromRgbF(1.0, 0, 0.5, 1);
+    QTest::newRow("glsl") << QString::fromLatin1("vec3(0.0, 1, 0)")
+                          << 0 << 15 << int(GlslFormat) << QColor::fromRgbF(0, 1, 0);
+    QTest::newRow("hex") << QString::fromLatin1("background: #FF8000;")
+                         << 12 << 7 << int(HexFormat) << QColor(255, 128, 0);
+    QTest::newRow("short hex") << QString::fromLatin1("#abcd")
+                               << 0 << 4 << int(HexFormat) << QColor(0xaa, 0xbb, 0xcc);
+    QTest::newRow("no name") << QString::fromLatin1("int red = 0;")
+                             << -1 << 0 << 0 << QColor();
+    QTest::newRow("out of range") << QString::fromLatin1("rgb(256, 0, 0)")
+                                  << -1 << 0 << 0 << QColor();
+    QTest::newRow("too long") << QString::fromLatin1("rgb(0,%1 0, 0)").arg(QString(96, QLatin1Char(' ')))
+                              << -1 << 0 << 0 << QColor();
+    QTest::newRow("leading zero") << QString::fromLatin1("rgb(012, 0, 0)")
+                                  << -1 << 0 << 0 << QColor();
+}
+
+void ColorPickerPlugin::test_scanColors()
+{
+    QFETCH(QString, text);
+    QFETCH(int, start);
+    QFETCH(int, length);
+    QFETCH(int, format);
+    QFETCH(QColor, color);
+
+    ColorScanner scanner;
+    const ColorMatchList matches = scanner.scan(text);
+
+    if (start < 0) {
+        QVERIFY(matches.isEmpty());
+        return;
+    }
+
+    QCOMPARE(matches.size(), 1);
+
+    const ColorMatch &match = matches.first();
+    QCOMPARE(match.start, start);
+    QCOMPARE(match.length, length);
+    QCOMPARE(int(match.format), format);
+    QCOMPARE(parseColor(text, match).rgba(), color.rgba());
+}
+
+void ColorPickerPlugin::test_scanColorNames_data()
+{
+    QTest::addColumn<QString>("text");
+    QTest::addColumn<int>("category");
+    QTest::addColumn<int>("start");
+    QTest::addColumn<QColor>("color");
+
+    QTest::newRow("name") << QString::fromLatin1("color: CornflowerBlue;") << int(CssCategory)
+                          << 7 << QColor(100, 149, 237);
+    QTest::newRow("transparent") << QString::fromLatin1("color: \"transparent\"") << int(QssCategory)
+                                 << 8 << QColor(0, 0, 0, 0);
+    QTest::newRow("name in identifier") << QString::fromLatin1("redirect(tan_1)") << int(CssCategory)
+                                        << -1 << QColor();
+    QTest::newRow("name as member") << QString::fromLatin1("palette.red, #red") << int(CssCategory)
+                                    << -1 << QColor();
+    QTest::newRow("c++ identifier") << QString::fromLatin1("int red = white + tan;") << int(AnyCategory)
+                                    << -1 << QColor();
+    QTest::newRow("qml") << QString::fromLatin1("color: red") << int(QmlCategory)
+                         << -1 << QColor();
+}
+
+void ColorPickerPlugin::test_scanColorNames()
+{
+    QFETCH(QString, text);
+    QFETCH(int, category);
+    QFETCH(int, start);
+    QFETCH(QColor, color);
+
+    ColorScanner scanner(formatsFromCategory(ColorCategory(category)));
+    const ColorMatchList matches = scanner.scan(text);
+
+    if (start < 0) {
+        QVERIFY(matches.isEmpty());
+        return;
+    }
+
+    QCOMPARE(matches.size(), 1);
+
+    const ColorMatch &match = matches.first();
+    QCOMPARE(match.start, start);
+    QCOMPARE(int(match.format), int(NamedColorFormat));
+    QCOMPARE(parseColor(text, match).rgba(), color.rgba());
+}
+
+void ColorPickerPlugin::test_findMatchAt()
+{
+    // Gradient stops : several colors of the same format on a single line
+    const QString text = QString::fromLatin1(
+                "stop: 0 #ff0000, stop: 0.5 rgb(0, 255, 0), stop: 1 #0000ff#00ff00");
+
+    ColorScanner scanner;
+    const ColorMatchList matches = scanner.scan(text);
+    QCOMPARE(matches.size(), 4);
+
+    QCOMPARE(findMatchAt(matches, 0), -1);
+    QCOMPARE(findMatchAt(matches, 8), 0);
+    QCOMPARE(findMatchAt(matches, 15), 0);
+    QCOMPARE(findMatchAt(matches, 16), -1);
+    QCOMPARE(findMatchAt(matches, text.indexOf(QLatin1String("255"))), 1);
+
+    // Touching expressions, the first one wins on the boundary
+    QCOMPARE(findMatchAt(matches, matches.at(3).start), 2);
+    QCOMPARE(findMatchAt(matches, matches.at(3).start + 1), 3);
+    QCOMPARE(findMatchAt(matches, text.size()), 3);
+}
+
+void ColorPickerPlugin::test_findColorCandidates()
+{
+    // Long enough for the vectorized loops, with non ASCII characters whose
+    // low byte is a candidate, and words a color name cannot start
+    QString text = QString::fromLatin1("color: Qt.rgba(1, 0, 0, 1); /* */ #fff vec3 ");
+    text += QChar(0x0152);
+    text += QChar(0x0172);
+    text += QChar(0x0123);
+    text += QString::fromLatin1(" $blue @gold _tan 9lime a-b .navy ");
+    text += QChar(0x00E9);
+    text += QString::fromLatin1("cyan{pink}");
+    text = text.repeated(3);
+
+    const QByteArray latin1 = text.toLatin1();
+
+    auto expectedCandidate = [](auto data, int begin, int from, int to, bool names) {
+        for (; from < to; ++from) {
+            const ushort before = (from > begin) ? ushort(data[from - 1]) : 0;
+            const ushort c = ushort(data[from]);
+
+            if (isColorCandidate(c) || (names && isNameCandidate(before, c)))
+                break;
+        }
+
+        return from;
+    };
+
+    const ushort *utf16 = text.utf16();
+    const uchar *bytes = reinterpret_cast<const uchar *>(latin1.constData());
+
+    for (int from = 0; from <= text.size(); ++from) {
+        QCOMPARE(findColorCandidate(text.constData(), from, text.size()),
+                 expectedCandidate(utf16, 0, from, text.size(), false));
+        QCOMPARE(findColorCandidate(latin1.constData(), from, latin1.size()),
+                 expectedCandidate(bytes, 0, from, latin1.size(), false));
+
+        // The character before 'from' is looked at only when the text has it
+        for (int begin : {0, from}) {
+            QCOMPARE(findColorOrNameCandidate(text.constData(), begin, from, text.size()),
+                     expectedCandidate(utf16, begin, from, text.size(), true));
+            QCOMPARE(findColorOrNameCandidate(latin1.constData(), begin, from, latin1.size()),
+                     expectedCandidate(bytes, begin, from, latin1.size(), true));
+        }
+    }
+}
+
+void ColorPickerPlugin::test_colorIndex()
+{
+    QTextDocument document(QString::fromLatin1("a: #fff;\nb: rgb(1, 2, 3);\nc: red;"));
+    ColorIndex index(&document, formatsFromCategory(CssCategory));
+
+    // Built on a worker thread
+    QTRY_VERIFY(index.isReady());
+
+    ColorIndexEntries entries = index.entries();
+    QCOMPARE(entries.size(), 3);
+    QCOMPARE(entries.at(0).offset, 3);
+    QCOMPARE(entries.at(1).offset, 12);
+    QCOMPARE(entries.at(2).offset, 29);
+    QCOMPARE(entries.at(2).format, NamedColorFormat);
+
+    // The edited line is indexed again and the next ones are shifted, right
+    // away and without a rebuild
+    QTextCursor cursor(&document);
+    cursor.setPosition(3);
+    cursor.insertText(QString::fromLatin1("#000 "));
+
+    QVERIFY(index.isReady());
+
+    entries = index.entries();
+    QCOMPARE(entries.size(), 4);
+    QCOMPARE(entries.at(0).offset, 3);
+    QCOMPARE(entries.at(0).value, QColor(Qt::black));
+    QCOMPARE(entries.at(1).offset, 8);
+    QCOMPARE(entries.at(2).offset, 17);
+    QCOMPARE(entries.at(2).length, 12);
+    QCOMPARE(entries.at(3).offset, 34);
+
+    // Removing a line merges the blocks around it
+    cursor.setPosition(14);
+    cursor.setPosition(31, QTextCursor::KeepAnchor);
+    cursor.removeSelectedText();
+
+    QVERIFY(index.isReady());
+
+    entries = index.entries();
+    QCOMPARE(entries.size(), 3);
+    QCOMPARE(entries.at(2).offset, 17);
+    QCOMPARE(entries.at(2).value, QColor(Qt::red));
+}
+
+void ColorPickerPlugin::test_colorToString_data()
+{
+    QTest::addColumn<QColor>("color");
+    QTest::addColumn<int>("format");
+    QTest::addColumn<int>("decimals");
+    QTest::addColumn<QString>("text");
+
+    QTest::newRow("rgb") << QColor(12, 20, 40) << int(QCssRgbUCharFormat) << 2
+                         << QString::fromLatin1("rgb(12, 20, 40)");
+    QTest::newRow("rgba") << QColor(255, 0, 0, 128) << int(QCssRgbUCharFormat) << 2
+                          << QString::fromLatin1("rgba(255, 0, 0, 0.50)");
+    QTest::newRow("hex") << QColor(255, 128, 0) << int(HexFormat) << 2
+                         << QString::fromLatin1("#FF8000");
+    QTest::newRow("hex alpha") << QColor(255, 128, 0, 16) << int(HexFormat) << 2
+                               << QString::fromLatin1("#10FF8000");
+    QTest::newRow("qml") << QColor(255, 0, 128) << int(QmlRgbaFormat) << 2
+                         << QString::fromLatin1("Qt.rgba(1.0, 0.0, 0.50, 1.0)");
+    QTest::newRow("qml 4 decimals") << QColor(10, 20, 30, 128) << int(QmlRgbaFormat) << 4
+                                    << QString::fromLatin1("Qt.rgba(0.0392, 0.0784, 0.1176, 0.5020)");
+    QTest::newRow("glsl 1 decimal") << QColor(10, 20, 30) << int(GlslFormat) << 1
+                                    << QString::fromLatin1("vec3(0.0, 0.1, 0.1)");
+    QTest::newRow("name") << QColor(100, 149, 237) << int(NamedColorFormat) << 2
+                          << QString::fromLatin1("cornflowerblue");
+    QTest::newRow("no name") << QColor(100, 149, 238) << int(NamedColorFormat) << 2
+                             << QString::fromLatin1("#6495EE");
+}
+
+void ColorPickerPlugin::test_colorToString()
+{
+    QFETCH(QColor, color);
+    QFETCH(int, format);
+    QFETCH(int, decimals);
+    QFETCH(QString, text);
+
+    QCOMPARE(colorToString(color, ColorFormat(format), decimals), text);
+}
+
+} // namespace Internal
+} // namespace ColorPicker
@@ -0,0 +1,224 @@
+#include "colortooltip.h"
+
+// Qt includes
+#include <QMouseEvent>
+#include <QTextBlock>
+#include <QTextLayout>
+#include <QTimer>
+#include <QToolTip>
+
+// QtCreator includes
+#include <texteditor/texteditor.h>
+
+// Plugin includes
+#include "colornames.h"
+#include "colorscanner.h"
+#include "colorwatcher.h"
+
+using namespace TextEditor;
+
+namespace {
+
+using namespace ColorPicker::Internal;
+
+const int HOVER_DELAY = 300; // ms
+
+QString tooltipText(const QColor &color)
+{
+    QString conversions;
+
+    for (int i = 0; i < COLOR_FORMAT_COUNT; ++i) {
+        const ColorFormat format = ColorFormat(i);
+
+        // Would repeat the hex conversion
+        if (format == NamedColorFormat && !colorName(color.rgba()))
+            continue;
+
+        if (!conversions.isEmpty())
+            conversions += QLatin1String("<br/>");
+
+        conversions += colorToString(color, format).toHtmlEscaped();
+    }
+
+    return QString::fromLatin1("<table><tr>"
+                               "<td bgcolor=\"%1\" width=\"48\" height=\"48\"></td>"
+                               "<td style=\"white-space: nowrap\">%2</td>"
+                               "</tr></table>")
+            .arg(color.name(QColor::HexArgb), conversions);
+}
+
+} // anon namespace
+
+namespace ColorPicker {
+namespace Internal {
+
+
+////////////////////////// ColorTooltipImpl //////////////////////////
+
+class ColorTooltipImpl
+{
+public:
+    ColorTooltipImpl(TextEditorWidget *editor, ColorWatcher *watcher);
+
+    /* functions */
+    void showTooltip();
+
+    /* variables */
+    TextEditorWidget *editor;
+    ColorWatcher *watcher;
+    bool enabled;
+
+    QTimer hoverTimer;
+    QPoint hoverPos;
+
+    // The last tooltip, rebuilt only when another expression is hovered
+    int lastBlockNumber;
+    int lastRevision;
+    int lastMatchStart;
+    QString lastText;
+    int builtCount;
+};
+
+ColorTooltipImpl::ColorTooltipImpl(TextEditorWidget *editor, ColorWatcher *watcher) :
+    editor(editor),
+    watcher(watcher),
+    enabled(true),
+    hoverTimer(),
+    hoverPos(),
+    lastBlockNumber(-1),
+    lastRevision(-1),
+    lastMatchStart(-1),
+    lastText(),
+    builtCount(0)
+{}
+
+void ColorTooltipImpl::showTooltip()
+{
+    const QTextCursor cursor = editor->cursorForPosition(hoverPos);
+    const QTextBlock block = cursor.block();
+
+    const BlockColors colors = watcher->colorsInBlock(block);
+    const int index = findMatchAt(colors.matches, cursor.positionInBlock());
+
+    if (index < 0) {
+        QToolTip::hideText();
+        return;
+    }
+
+    const ColorMatch &match = colors.matches.at(index);
+
+    // cursorForPosition() returns the closest position, make sure the mouse
+    // really is over the expression. A wrapped expression spans several
+    // visual lines, only the part on the hovered line is kept.
+    const int hoverPosition = cursor.positionInBlock();
+    const QTextLine line = block.layout()->lineForTextPosition(hoverPosition);
+
+    if (!line.isValid()) {
+        QToolTip::hideText();
+        return;
+    }
+
+    const int partStart = qMax(match.start, line.textStart());
+    const int partEnd = qMin(match.end(), line.textStart() + line.textLength());
+
+    QTextCursor startCursor(block);
+    startCursor.setPosition(block.position() + partStart);
+
+    const QRect startRect = editor->cursorRect(startCursor);
+
+    const int startX = qRound(line.cursorToX(partStart));
+    const int endX = qRound(line.cursorToX(partEnd));
+
+    const QRect expressionRect(startRect.left() + qMin(endX - startX, 0), startRect.top(),
+                               qAbs(endX - startX), startRect.height());
+
+    if (!expressionRect.contains(hoverPos)) {
+        QToolTip::hideText();
+        return;
+    }
+
+    if (block.blockNumber() != lastBlockNumber || block.revision() != lastRevision
+            || match.start != lastMatchStart) {
+        lastBlockNumber = block.blockNumber();
+        lastRevision = block.revision();
+        lastMatchStart = match.start;
+        lastText = tooltipText(colors.values.at(index));
+        ++builtCount;
+    }
+
+    QWidget *viewport = editor->viewport();
+
+    QToolTip::showText(viewport->mapToGlobal(hoverPos), lastText, viewport, expressionRect);
+}
+
+
+////////////////////////// ColorTooltip //////////////////////////
+
+ColorTooltip::ColorTooltip(TextEditorWidget *editor, ColorWatcher *watcher) :
+    QObject(watcher),
+    d(new ColorTooltipImpl(editor, watcher))
+{
+    d->hoverTimer.setSingleShot(true);
+    d->hoverTimer.setInterval(HOVER_DELAY);
+
+    connect(&d->hoverTimer, &QTimer::timeout,
+            this, [=]() { d->showTooltip(); });
+
+    editor->viewport()->setMouseTracking(true);
+    editor->viewport()->installEventFilter(this);
+}
+
+ColorTooltip::~ColorTooltip()
+{}
+
+bool ColorTooltip::isEnabled() const
+{
+    return d->enabled;
+}
+
+void ColorTooltip::setEnabled(bool enabled)
+{
+    d->enabled = enabled;
+
+    if (!enabled)
+        d->hoverTimer.stop();
+}
+
+int ColorTooltip::builtCount() const
+{
+    return d->builtCount;
+}
+
+bool ColorTooltip::eventFilter(QObject *watched, QEvent *event)
+{
+    Q_UNUSED(watched);
+
+    if (!d->enabled)
+        return false;
+
+    switch (event->type()) {
+    case QEvent::MouseMove:
+        // Only the position where the mouse rests gets looked up
+        d->hoverPos = static_cast<QMouseEvent *>(event)->pos();
+        d->hoverTimer.start();
+        break;
+    case QEvent::HoverMove:
+        // Sent instead when the viewport has Qt::WA_Hover
+        d->hoverPos = static_cast<QHoverEvent *>(event)->pos();
+        d->hoverTimer.start();
+        break;
+    case QEvent::Leave:
+    case QEvent::MouseButtonPress:
+    case QEvent::KeyPress:
+    case QEvent::Wheel:
+        d->hoverTimer.stop();
+        break;
+    default:
+        break;
+    }
+
+    return false;
+}
+
+} // namespace Internal
+} // namespace ColorPicker
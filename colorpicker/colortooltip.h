@@ -0,0 +1,43 @@
+#ifndef COLORTOOLTIP_H
+#define COLORTOOLTIP_H
+
+#include <QObject>
+
+namespace TextEditor {
+class TextEditorWidget;
+}
+
+namespace ColorPicker {
+namespace Internal {
+
+class ColorTooltipImpl;
+class ColorWatcher;
+
+// Shows the color under the mouse with its conversions to the other formats.
+// The lookup only runs once the mouse rests, and reuses the block cache of
+// the watcher.
+class ColorTooltip : public QObject
+{
+    Q_OBJECT
+
+public:
+    ColorTooltip(TextEditor::TextEditorWidget *editor, ColorWatcher *watcher);
+    ~ColorTooltip();
+
+    bool isEnabled() const;
+    void setEnabled(bool enabled);
+
+    // Tooltips built so far, hovering the same expression again reuses the last one
+    int builtCount() const;
+
+protected:
+    bool eventFilter(QObject *watched, QEvent *event) override;
+
+private:
+    QScopedPointer<ColorTooltipImpl> d;
+};
+
+} // namespace Internal
+} // namespace ColorPicker
+
+#endif // COLORTOOLTIP_H
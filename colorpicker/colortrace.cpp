@@ -0,0 +1,206 @@
+#include "colortrace.h"
+
+// Qt includes
+#include <QCoreApplication>
+#include <QDir>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QHash>
+#include <QMutex>
+#include <QThread>
+#include <QVector>
+
+namespace {
+
+// About 48 MB, the next events are dropped
+const int MAX_TRACE_EVENTS = 1 << 20;
+
+struct TraceEvent
+{
+    const char *name;           // Literals only
+    char phase;                 // 'X' complete, 'b' and 'e' async begin and end
+    qint64 timestamp;           // us
+    qint64 duration;            // us, complete events
+    quint64 id;                 // Async events
+    quintptr threadId;
+};
+
+class TraceRecorder
+{
+public:
+    TraceRecorder() :
+        mutex(),
+        clock(),
+        events(),
+        runningSpans(),
+        nextId(1)
+    {
+        clock.start();
+    }
+
+    qint64 now() const
+    {
+        return clock.nsecsElapsed() / 1000;
+    }
+
+    void record(const char *name, char phase, qint64 timestamp, qint64 duration, quint64 id)
+    {
+        if (events.size() >= MAX_TRACE_EVENTS)
+            return;
+
+        TraceEvent event;
+        event.name = name;
+        event.phase = phase;
+        event.timestamp = timestamp;
+        event.duration = duration;
+        event.id = id;
+        event.threadId = quintptr(QThread::currentThreadId());
+
+        events.append(event);
+    }
+
+    QMutex mutex;
+    QElapsedTimer clock;
+    QVector<TraceEvent> events;
+    QHash<QByteArray, quint64> runningSpans;    // Async ids by name
+    quint64 nextId;
+};
+
+Q_GLOBAL_STATIC(TraceRecorder, recorder)
+
+} // anon namespace
+
+namespace ColorPicker {
+namespace Internal {
+
+Q_LOGGING_CATEGORY(traceLog, "qtc.colorpicker.trace")
+
+TraceSpan::TraceSpan(const char *name) :
+    m_name(name),
+    m_start(traceLog().isDebugEnabled() ? recorder()->now() : -1)
+{}
+
+TraceSpan::~TraceSpan()
+{
+    if (m_start < 0)
+        return;
+
+    TraceRecorder *r = recorder();
+    const qint64 end = r->now();
+
+    QMutexLocker locker(&r->mutex);
+    r->record(m_name, 'X', m_start, end - m_start, 0);
+}
+
+void traceBegin(const char *name)
+{
+    if (!traceLog().isDebugEnabled())
+        return;
+
+    TraceRecorder *r = recorder();
+    QMutexLocker locker(&r->mutex);
+
+    const QByteArray key(name);
+
+    if (r->runningSpans.contains(key))
+        return;
+
+    const quint64 id = r->nextId++;
+    r->runningSpans.insert(key, id);
+    r->record(name, 'b', r->now(), 0, id);
+}
+
+void traceEnd(const char *name)
+{
+    if (!traceLog().isDebugEnabled())
+        return;
+
+    TraceRecorder *r = recorder();
+    QMutexLocker locker(&r->mutex);
+
+    const quint64 id = r->runningSpans.take(QByteArray(name));
+
+    if (id)
+        r->record(name, 'e', r->now(), 0, id);
+}
+
+void traceCancel(const char *name)
+{
+    if (!traceLog().isDebugEnabled())
+        return;
+
+    TraceRecorder *r = recorder();
+    QMutexLocker locker(&r->mutex);
+
+    const quint64 id = r->runningSpans.take(QByteArray(name));
+
+    if (!id)
+        return;
+
+    // Its begin is among the last events
+    for (int i = r->events.size() - 1; i >= 0; --i) {
+        if (r->events.at(i).id == id) {
+            r->events.remove(i);
+            break;
+        }
+    }
+}
+
+QString traceFileName()
+{
+    const QString ret = QString::fromLocal8Bit(qgetenv("QTC_COLORPICKER_TRACE_FILE"));
+
+    if (!ret.isEmpty())
+        return ret;
+
+    return QDir::tempPath() + QLatin1String("/colorpicker-trace.json");
+}
+
+bool writeTrace(const QString &fileName)
+{
+    TraceRecorder *r = recorder();
+    QMutexLocker locker(&r->mutex);
+
+    QFile file(fileName);
+
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate | QIODevice::Text))
+        return false;
+
+    const QByteArray pid = QByteArray::number(QCoreApplication::applicationPid());
+
+    QByteArray ret("{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n");
+
+    for (int i = 0; i < r->events.size(); ++i) {
+        const TraceEvent &event = r->events.at(i);
+
+        // The names are literals of the plugin, nothing to escape
+        ret += "{\"name\":\"";
+        ret += event.name;
+        ret += "\",\"cat\":\"colorpicker\",\"ph\":\"";
+        ret += event.phase;
+        ret += "\",\"ts\":";
+        ret += QByteArray::number(event.timestamp);
+
+        if (event.phase == 'X') {
+            ret += ",\"dur\":";
+            ret += QByteArray::number(event.duration);
+        }
+        else {
+            ret += ",\"id\":";
+            ret += QByteArray::number(event.id);
+        }
+
+        ret += ",\"pid\":";
+        ret += pid;
+        ret += ",\"tid\":";
+        ret += QByteArray::number(quint64(event.threadId));
+        ret += (i + 1 < r->events.size()) ? "},\n" : "}\n";
+    }
+
+    ret += "]}\n";
+
+    return file.write(ret) == ret.size();
+}
+
+} // namespace Internal
+} // namespace ColorPicker
@@ -0,0 +1,46 @@
+#ifndef COLORTRACE_H
+#define COLORTRACE_H
+
+#include <QLoggingCategory>
+
+namespace ColorPicker {
+namespace Internal {
+
+// QT_LOGGING_RULES="qtc.colorpicker.trace=true" records the spans below. They
+// are written when the plugin is unloaded, as a Chrome trace-event file
+// (chrome://tracing, ui.perfetto.dev), see traceFileName().
+Q_DECLARE_LOGGING_CATEGORY(traceLog)
+
+// Spans across several events
+const char TRACE_TRIGGER_TO_PAINT[] = "Color edit trigger to color picker paint";
+const char TRACE_CHANGE_TO_WRITE[] = "Color change to document write";
+
+// Records the time between its construction and its destruction
+class TraceSpan
+{
+public:
+    explicit TraceSpan(const char *name);
+    ~TraceSpan();
+
+private:
+    Q_DISABLE_COPY(TraceSpan)
+
+    const char *m_name;
+    qint64 m_start;             // us, -1 when tracing is disabled
+};
+
+// Spans across several events, e.g. from a trigger to the next paint. Beginning
+// a running span or ending a stopped one does nothing, so a span whose end will
+// not come has to be cancelled : the next begin would be ignored.
+void traceBegin(const char *name);
+void traceEnd(const char *name);
+void traceCancel(const char *name);
+
+// QTC_COLORPICKER_TRACE_FILE, or colorpicker-trace.json in the temporary directory
+QString traceFileName();
+bool writeTrace(const QString &fileName);
+
+} // namespace Internal
+} // namespace ColorPicker
+
+#endif // COLORTRACE_H
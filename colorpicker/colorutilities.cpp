@@ -1,285 +1,671 @@
 #include "colorutilities.h"
 
 #include <QDebug> // REMOVEME
-#include <QRegularExpression>
+#include <QFileInfo>
+#include <QStringList>
+
+#include "colornames.h"
 
 namespace {
 
 
 ////////////////////// Parsing Helpers //////////////////////
 
-QString colorDoubleToQString(double n)
+using namespace ColorPicker::Internal;
+
+inline ushort unicodeOf(QChar c)
 {
-    QString ret = QString::number(n, 'f', 2);
+    return c.unicode();
+}
 
-    QString toReplace = QLatin1String(".00");
-    if (ret.contains(toReplace))
-        ret.replace(toReplace, QLatin1String(".0"));
+inline ushort unicodeOf(char c)
+{
+    return uchar(c);
+}
 
-    return ret;
+inline int hexDigitValue(ushort c)
+{
+    if (c >= '0' && c <= '9')
+        return c - '0';
+
+    return (c | 0x20) - 'a' + 10;
 }
 
-void parseQCssRgbUChar(const QRegularExpressionMatch &match, QColor &result)
+// Decodes the components of a scanned color expression in place. The scanner
+// already validated them : digits with an optional dot, the percent sign
+// excluded from the capture.
+template <typename Char>
+class ScannedComponents
+{
+public:
+    ScannedComponents(const Char *data, const ColorMatch &match) :
+        m_data(data),
+        m_match(match)
+    {}
+
+    bool has(int nth) const
+    {
+        return (nth <= m_match.capturedCount);
+    }
+
+    int toInt(int nth) const
+    {
+        const Char *it = m_data + m_match.capturedStart[nth - 1];
+        const Char *end = it + m_match.capturedLength[nth - 1];
+
+        int ret = 0;
+
+        for (; it != end; ++it)
+            ret = ret * 10 + (unicodeOf(*it) - '0');
+
+        return ret;
+    }
+
+    qreal toReal(int nth) const
+    {
+        const Char *it = m_data + m_match.capturedStart[nth - 1];
+        const Char *end = it + m_match.capturedLength[nth - 1];
+
+        // Digits past the 19th cannot change a color channel, they are dropped
+        // to keep the mantissa in 64 bits
+        const int MAX_DIGIT_COUNT = 19;
+
+        quint64 mantissa = 0;
+        int digitCount = 0;
+        int fractionDigitCount = 0;
+        bool inFraction = false;
+
+        for (; it != end; ++it) {
+            const ushort c = unicodeOf(*it);
+
+            if (c == '.') {
+                inFraction = true;
+                continue;
+            }
+
+            if (digitCount == MAX_DIGIT_COUNT)
+                continue;
+
+            mantissa = mantissa * 10 + (c - '0');
+
+            if (mantissa)
+                ++digitCount;
+
+            if (inFraction)
+                ++fractionDigitCount;
+        }
+
+        static const qreal POWERS_OF_TEN[] = {
+            1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10,
+            1e11, 1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19
+        };
+
+        qreal ret = qreal(mantissa);
+
+        // Leading zeros of the fraction may go past the table
+        while (fractionDigitCount > MAX_DIGIT_COUNT) {
+            ret /= POWERS_OF_TEN[MAX_DIGIT_COUNT];
+            fractionDigitCount -= MAX_DIGIT_COUNT;
+        }
+
+        return ret / POWERS_OF_TEN[fractionDigitCount];
+    }
+
+    // Value of count hexadecimal digits, starting at the offset-th one after '#'
+    int hexValue(int offset, int count) const
+    {
+        const Char *it = m_data + m_match.start + 1 + offset;
+
+        int ret = 0;
+
+        for (int i = 0; i < count; ++i)
+            ret = (ret << 4) | hexDigitValue(unicodeOf(it[i]));
+
+        return ret;
+    }
+
+    int hexDigitCount() const
+    {
+        return m_match.length - 1;
+    }
+
+    bool namedValue(QRgb *value) const
+    {
+        if (m_match.length > COLOR_NAME_MAX_LENGTH)
+            return false;
+
+        char name[COLOR_NAME_MAX_LENGTH];
+        const Char *it = m_data + m_match.start;
+
+        for (int i = 0; i < m_match.length; ++i)
+            name[i] = char(unicodeOf(it[i]) | 0x20);
+
+        return findNamedColor(name, m_match.length, value);
+    }
+
+private:
+    const Char *m_data;
+    const ColorMatch &m_match;
+};
+
+template <typename Char>
+void parseQCssRgbUChar(const ScannedComponents<Char> &match, QColor &result)
 {
-    int r = match.captured(1).toInt();
-    int g = match.captured(2).toInt();
-    int b = match.captured(3).toInt();
+    int r = match.toInt(1);
+    int g = match.toInt(2);
+    int b = match.toInt(3);
 
     result.setRgb(r, g, b);
 
-    QString possibleAlpha = match.captured(4);
-    if (!possibleAlpha.isNull()) {
-        qreal a = possibleAlpha.toDouble();
+    if (match.has(4)) {
+        qreal a = match.toReal(4);
 
         result.setAlphaF(a);
     }
 }
 
-void parseCssRgbPercent(const QRegularExpressionMatch &match, QColor &result)
+template <typename Char>
+void parseCssRgbPercent(const ScannedComponents<Char> &match, QColor &result)
 {
-    QChar percentChar = QChar::fromLatin1('%');
-
-    qreal r = match.captured(1).remove(percentChar).toDouble() / 100;
-    qreal g = match.captured(2).remove(percentChar).toDouble() / 100;
-    qreal b = match.captured(3).remove(percentChar).toDouble() / 100;
+    qreal r = match.toInt(1) / qreal(100);
+    qreal g = match.toInt(2) / qreal(100);
+    qreal b = match.toInt(3) / qreal(100);
 
     result.setRgbF(r, g, b);
 
-    QString possibleAlpha = match.captured(4);
-    if (!possibleAlpha.isNull()) {
-        qreal a = possibleAlpha.toDouble();
+    if (match.has(4)) {
+        qreal a = match.toReal(4);
 
         result.setAlphaF(a);
     }
 }
 
-void parseQssHsv(const QRegularExpressionMatch &match, QColor &result)
+template <typename Char>
+void parseQssHsv(const ScannedComponents<Char> &match, QColor &result)
 {
-    int h = match.captured(1).toInt();
-    int s = match.captured(2).toInt();
-    int v = match.captured(3).toInt();
+    int h = match.toInt(1);
+    int s = match.toInt(2);
+    int v = match.toInt(3);
 
     result.setHsv(h, s, v);
 
-    QString possibleAlpha = match.captured(4);
-
-    if (!possibleAlpha.isNull()) {
-        qreal a = possibleAlpha.remove(QChar::fromLatin1('%')).toDouble() / 100;
+    if (match.has(4)) {
+        qreal a = match.toInt(4) / qreal(100);
 
         result.setAlphaF(a);
     }
 }
 
-void parseCssHsl(const QRegularExpressionMatch &match, QColor &result)
+template <typename Char>
+void parseCssHsl(const ScannedComponents<Char> &match, QColor &result)
 {
-    QChar percentChar = QChar::fromLatin1('%');
-
-    int h = match.captured(1).toInt();
-    int s = match.captured(2).remove(percentChar).toInt() * 255 / 100;
-    int l = match.captured(3).remove(percentChar).toInt() * 255 / 100;
+    int h = match.toInt(1);
+    int s = match.toInt(2) * 255 / 100;
+    int l = match.toInt(3) * 255 / 100;
 
     result.setHsl(h, s, l);
 
-    QString possibleAlpha = match.captured(4);
-    if (!possibleAlpha.isNull()) {
-        qreal a = possibleAlpha.toDouble();
+    if (match.has(4)) {
+        qreal a = match.toReal(4);
 
         result.setAlphaF(a);
     }
 }
 
-void parseQmlRgba(const QRegularExpressionMatch &match, QColor &result)
+template <typename Char>
+void parseQmlRgba(const ScannedComponents<Char> &match, QColor &result)
 {
-    qreal r = match.captured(1).toDouble();
-    qreal g = match.captured(2).toDouble();
-    qreal b = match.captured(3).toDouble();
-    qreal a = match.captured(4).toDouble();
+    qreal r = match.toReal(1);
+    qreal g = match.toReal(2);
+    qreal b = match.toReal(3);
+    qreal a = match.toReal(4);
 
     result.setRgbF(r, g, b, a);
 }
 
-void parseQmlHsla(const QRegularExpressionMatch &match, QColor &result)
+template <typename Char>
+void parseQmlHsla(const ScannedComponents<Char> &match, QColor &result)
 {
-    qreal h = match.captured(1).toDouble();
-    qreal s = match.captured(2).toDouble();
-    qreal l = match.captured(3).toDouble();
-    qreal a = match.captured(4).toDouble();
+    qreal h = match.toReal(1);
+    qreal s = match.toReal(2);
+    qreal l = match.toReal(3);
+    qreal a = match.toReal(4);
 
     result.setHslF(h, s, l, a);
 }
 
-void parseGlslColor(const QRegularExpressionMatch &match, QColor &result)
+template <typename Char>
+void parseGlslColor(const ScannedComponents<Char> &match, QColor &result)
 {
-    qreal r = match.captured(1).toDouble();
-    qreal g = match.captured(2).toDouble();
-    qreal b = match.captured(3).toDouble();
+    qreal r = match.toReal(1);
+    qreal g = match.toReal(2);
+    qreal b = match.toReal(3);
 
     result.setRgbF(r, g, b);
 
-    QString possibleAlpha = match.captured(4);
-    if (!possibleAlpha.isNull()) {
-        qreal a = possibleAlpha.toDouble();
+    if (match.has(4)) {
+        qreal a = match.toReal(4);
 
         result.setAlphaF(a);
     }
 }
 
-void parseHexColor(const QRegularExpressionMatch &match, QColor &result)
+// Same channel expansion as QColor::setNamedColor()
+template <typename Char>
+void parseHexColor(const ScannedComponents<Char> &match, QColor &result)
 {
-    result.setNamedColor(match.captured());
+    int a = 0xffff;
+    int r = 0;
+    int g = 0;
+    int b = 0;
+
+    switch (match.hexDigitCount()) {
+    case 12:
+        r = match.hexValue(0, 4);
+        g = match.hexValue(4, 4);
+        b = match.hexValue(8, 4);
+        break;
+    case 9:
+        r = match.hexValue(0, 3);
+        g = match.hexValue(3, 3);
+        b = match.hexValue(6, 3);
+        r = (r << 4) | (r >> 8);
+        g = (g << 4) | (g >> 8);
+        b = (b << 4) | (b >> 8);
+        break;
+    case 8:
+        a = match.hexValue(0, 2) * 0x101;
+        r = match.hexValue(2, 2) * 0x101;
+        g = match.hexValue(4, 2) * 0x101;
+        b = match.hexValue(6, 2) * 0x101;
+        break;
+    case 6:
+        r = match.hexValue(0, 2) * 0x101;
+        g = match.hexValue(2, 2) * 0x101;
+        b = match.hexValue(4, 2) * 0x101;
+        break;
+    case 3:
+        r = match.hexValue(0, 1) * 0x1111;
+        g = match.hexValue(1, 1) * 0x1111;
+        b = match.hexValue(2, 1) * 0x1111;
+        break;
+    default:
+        return;
+    }
+
+    result = QColor::fromRgba64(quint16(r), quint16(g), quint16(b), quint16(a));
 }
 
+template <typename Char>
+void parseNamedColor(const ScannedComponents<Char> &match, QColor &result)
+{
+    QRgb value;
+
+    if (match.namedValue(&value))
+        result = QColor::fromRgba(value);
+}
 
 ////////////////////// ColorToString Helpers //////////////////////
 
-void cssRgbUCharToQString(const QColor &color, QString &prefix,
-                          QString &parts)
+// Writes an expression in a stack buffer, the string being allocated once at
+// the end. The numbers are generated from integers, without any conversion
+// through printf.
+class ColorWriter
 {
-    prefix = QLatin1String("rgb(");
+public:
+    ColorWriter() :
+        m_size(0)
+    {}
 
-    const QString COMMA_SEP_STRING = QLatin1String(", ");
+    void append(char c)
+    {
+        Q_ASSERT(m_size < CAPACITY);
 
-    parts = QString::number(color.red()) + COMMA_SEP_STRING
-            + QString::number(color.green()) + COMMA_SEP_STRING
-            + QString::number(color.blue());
+        m_data[m_size++] = c;
+    }
 
-    qreal alpha = color.alphaF();
-    if (alpha < 1.0) {
-        prefix.insert(3, QLatin1Char('a'));
-        parts += COMMA_SEP_STRING + colorDoubleToQString(color.alphaF());
+    void append(const char *literal)
+    {
+        while (*literal)
+            append(*literal++);
     }
-}
 
-void cssRgbPercentToQString(const QColor &color, QString &prefix,
-                            QString &parts)
-{
-    QChar percentChar = QChar::fromLatin1('%');
+    void appendInt(int n)
+    {
+        // Hues of the achromatic colors are -1
+        if (n < 0) {
+            append('-');
+            n = -n;
+        }
+
+        char digits[10];
+        int count = 0;
+
+        do {
+            digits[count++] = char('0' + n % 10);
+            n /= 10;
+        } while (n);
+
+        while (count)
+            append(digits[--count]);
+    }
 
-    int rP = qRound(color.redF() * 100);
-    int gP = qRound(color.greenF() * 100);
-    int bP = qRound(color.blueF() * 100);
+    // Fixed-point with the given number of decimals, a zero fraction being
+    // written ".0" (1.0, 0.50, 0.25)
+    void appendReal(qreal value, int decimals)
+    {
+        static const int SCALES[] = { 1, 10, 100, 1000, 10000 };
 
-    prefix = QLatin1String("rgb(");
+        Q_ASSERT(decimals >= MIN_COLOR_DECIMALS && decimals <= MAX_COLOR_DECIMALS);
 
-    const QString COMMA_SEP_STRING = QLatin1String(", ");
+        if (value < 0) {
+            append('-');
+            value = -value;
+        }
 
-    parts = QString::number(rP) + percentChar + COMMA_SEP_STRING
-            + QString::number(gP)
-            + percentChar + COMMA_SEP_STRING
-            + QString::number(bP) + percentChar;
+        const int scale = SCALES[decimals];
+        const int scaled = qRound(value * scale);
+        const int fraction = scaled % scale;
 
-    qreal alpha = color.alphaF();
+        appendInt(scaled / scale);
+        append('.');
+
+        if (!fraction) {
+            append('0');
+            return;
+        }
+
+        for (int divisor = scale / 10; divisor; divisor /= 10)
+            append(char('0' + fraction / divisor % 10));
+    }
+
+    void appendHexByte(int byte)
+    {
+        static const char HEX_DIGITS[] = "0123456789ABCDEF";
+
+        append(HEX_DIGITS[(byte >> 4) & 0xf]);
+        append(HEX_DIGITS[byte & 0xf]);
+    }
+
+    QString toString() const
+    {
+        return QString::fromLatin1(m_data, m_size);
+    }
+
+private:
+    // "Qt.hsla(1.0000, 1.0000, 1.0000, 1.0000)" is the longest expression
+    static const int CAPACITY = 64;
+
+    char m_data[CAPACITY];
+    int m_size;
+};
+
+void cssRgbUCharToQString(const QColor &color, int decimals, ColorWriter &out)
+{
+    const qreal alpha = color.alphaF();
+
+    out.append((alpha < 1.0) ? "rgba(" : "rgb(");
+    out.appendInt(color.red());
+    out.append(", ");
+    out.appendInt(color.green());
+    out.append(", ");
+    out.appendInt(color.blue());
 
     if (alpha < 1.0) {
-        prefix.insert(3, QLatin1Char('a'));
-        parts += COMMA_SEP_STRING + colorDoubleToQString(alpha);
+        out.append(", ");
+        out.appendReal(alpha, decimals);
     }
 
+    out.append(')');
 }
 
-void qssHsvToQString(const QColor &color, QString &prefix, QString &parts)
+void cssRgbPercentToQString(const QColor &color, int decimals, ColorWriter &out)
 {
-    prefix = QLatin1String("hsv(");
+    const qreal alpha = color.alphaF();
+
+    out.append((alpha < 1.0) ? "rgba(" : "rgb(");
+    out.appendInt(qRound(color.redF() * 100));
+    out.append("%, ");
+    out.appendInt(qRound(color.greenF() * 100));
+    out.append("%, ");
+    out.appendInt(qRound(color.blueF() * 100));
+    out.append('%');
+
+    if (alpha < 1.0) {
+        out.append(", ");
+        out.appendReal(alpha, decimals);
+    }
 
-    const QString COMMA_SEP_STRING = QLatin1String(", ");
+    out.append(')');
+}
 
-    parts = QString::number(color.hsvHue()) + COMMA_SEP_STRING
-            + QString::number(color.hsvSaturation()) + COMMA_SEP_STRING
-            + QString::number(color.value());
+void qssHsvToQString(const QColor &color, int decimals, ColorWriter &out)
+{
+    Q_UNUSED(decimals);
 
-    int aP = qRound(color.alphaF() * 100);
+    const int aP = qRound(color.alphaF() * 100);
+
+    out.append((aP < 100) ? "hsva(" : "hsv(");
+    out.appendInt(color.hsvHue());
+    out.append(", ");
+    out.appendInt(color.hsvSaturation());
+    out.append(", ");
+    out.appendInt(color.value());
 
     if (aP < 100) {
-        prefix.insert(3, QLatin1Char('a'));
-        parts += COMMA_SEP_STRING + QString::number(aP)
-                + QChar::fromLatin1('%');
+        out.append(", ");
+        out.appendInt(aP);
+        out.append('%');
     }
+
+    out.append(')');
 }
 
-void cssHslToQString(const QColor &color, QString &prefix, QString &parts)
+void cssHslToQString(const QColor &color, int decimals, ColorWriter &out)
 {
-    prefix = QLatin1String("hsl(");
+    const qreal alpha = color.alphaF();
 
-    int sP = qRound(color.hslSaturationF() * 100);
-    int lP = qRound(color.lightnessF() * 100);
+    out.append((alpha < 1.0) ? "hsla(" : "hsl(");
+    out.appendInt(color.hslHue());
+    out.append(", ");
+    out.appendInt(qRound(color.hslSaturationF() * 100));
+    out.append("%, ");
+    out.appendInt(qRound(color.lightnessF() * 100));
+    out.append('%');
 
-    QChar percentChar = QChar::fromLatin1('%');
+    if (alpha < 1.0) {
+        out.append(", ");
+        out.appendReal(alpha, decimals);
+    }
+
+    out.append(')');
+}
 
-    const QString COMMA_SEP_STRING = QLatin1String(", ");
+void qmlRgbaToQString(const QColor &color, int decimals, ColorWriter &out)
+{
+    out.append("Qt.rgba(");
+    out.appendReal(color.redF(), decimals);
+    out.append(", ");
+    out.appendReal(color.greenF(), decimals);
+    out.append(", ");
+    out.appendReal(color.blueF(), decimals);
+    out.append(", ");
+    out.appendReal(color.alphaF(), decimals);
+    out.append(')');
+}
+
+void qmlHslaToQString(const QColor &color, int decimals, ColorWriter &out)
+{
+    out.append("Qt.hsla(");
+    out.appendReal(color.hueF(), decimals);
+    out.append(", ");
+    out.appendReal(color.saturationF(), decimals);
+    out.append(", ");
+    out.appendReal(color.lightnessF(), decimals);
+    out.append(", ");
+    out.appendReal(color.alphaF(), decimals);
+    out.append(')');
+}
+
+void glslColorToQString(const QColor &color, int decimals, ColorWriter &out)
+{
+    const qreal alpha = color.alphaF();
 
-    parts = QString::number(color.hslHue()) + COMMA_SEP_STRING
-            + QString::number(sP) + percentChar
-            + COMMA_SEP_STRING
-            + QString::number(lP) + percentChar;
+    out.append((alpha < 1.0) ? "vec4(" : "vec3(");
+    out.appendReal(color.redF(), decimals);
+    out.append(", ");
+    out.appendReal(color.greenF(), decimals);
+    out.append(", ");
+    out.appendReal(color.blueF(), decimals);
 
-    qreal alpha = color.alphaF();
     if (alpha < 1.0) {
-        prefix.insert(3, QLatin1Char('a'));
-        parts += COMMA_SEP_STRING + colorDoubleToQString(color.alphaF());
+        out.append(", ");
+        out.appendReal(alpha, decimals);
     }
+
+    out.append(')');
 }
 
-void qmlRgbaToQString(const QColor &color, QString &prefix, QString &parts)
+void hexColorToQString(const QColor &color, int decimals, ColorWriter &out)
 {
-    prefix = QLatin1String("Qt.rgba(");
+    Q_UNUSED(decimals);
+
+    const int alpha = color.alpha();
+
+    out.append('#');
 
-    const QString COMMA_SEP_STRING = QLatin1String(", ");
+    if (alpha < 255)
+        out.appendHexByte(alpha);
 
-    parts = colorDoubleToQString(color.redF()) + COMMA_SEP_STRING
-            + colorDoubleToQString(color.greenF()) + COMMA_SEP_STRING
-            + colorDoubleToQString(color.blueF()) + COMMA_SEP_STRING
-            + colorDoubleToQString(color.alphaF());
+    out.appendHexByte(color.red());
+    out.appendHexByte(color.green());
+    out.appendHexByte(color.blue());
 }
 
-void qmlHslaToQString(const QColor &color, QString &prefix, QString &parts)
+// Colors without a name are written in hex
+void namedColorToQString(const QColor &color, int decimals, ColorWriter &out)
 {
-    prefix = QLatin1String("Qt.hsla(");
+    const char *name = colorName(color.rgba());
 
-    const QString COMMA_SEP_STRING = QLatin1String(", ");
+    if (!name) {
+        hexColorToQString(color, decimals, out);
+        return;
+    }
 
-    parts = colorDoubleToQString(color.hueF()) + COMMA_SEP_STRING
-            + colorDoubleToQString(color.saturationF()) + COMMA_SEP_STRING
-            + colorDoubleToQString(color.lightnessF()) + COMMA_SEP_STRING
-            + colorDoubleToQString(color.alphaF());
+    out.append(name);
+}
 
+
+////////////////////// Format Registry //////////////////////
+
+typedef void (*Utf16Parser)(const ScannedComponents<QChar> &, QColor &);
+typedef void (*Latin1Parser)(const ScannedComponents<char> &, QColor &);
+typedef void (*Formatter)(const QColor &, int, ColorWriter &);
+
+constexpr quint32 categoryBit(ColorCategory category)
+{
+    return (1u << category);
 }
 
-void glslColorToQString(const QColor &color, QString &prefix, QString &parts)
+const quint32 ANY = categoryBit(AnyCategory);
+const quint32 QSS = categoryBit(QssCategory);
+const quint32 CSS = categoryBit(CssCategory);
+const quint32 QML = categoryBit(QmlCategory);
+const quint32 GLSL = categoryBit(GlslCategory);
+
+struct ColorFormatDescriptor
 {
-    prefix = QLatin1String("vec");
+    ColorFormat format;
+    const char *buttonLabel;
+    ColorFormat buttonOwner;
+    quint32 categories;
+    Utf16Parser parseUtf16;
+    Latin1Parser parseLatin1;
+    Formatter toString;
+};
+
+// Indexed by ColorFormat. Adding a format only takes a new entry. The names
+// stay out of AnyCategory, they would match plain identifiers of C++ code.
+constexpr ColorFormatDescriptor FORMAT_REGISTRY[] =
+{
+    { QCssRgbUCharFormat, "rgb", QCssRgbUCharFormat, ANY | QSS | CSS,
+      &parseQCssRgbUChar<QChar>, &parseQCssRgbUChar<char>, &cssRgbUCharToQString },
+    { QCssRgbPercentFormat, nullptr, QCssRgbUCharFormat, ANY | QSS | CSS,
+      &parseCssRgbPercent<QChar>, &parseCssRgbPercent<char>, &cssRgbPercentToQString },
+    { QssHsvFormat, "hsv", QssHsvFormat, ANY | QSS,
+      &parseQssHsv<QChar>, &parseQssHsv<char>, &qssHsvToQString },
+    { CssHslFormat, "hsl", CssHslFormat, ANY | CSS,
+      &parseCssHsl<QChar>, &parseCssHsl<char>, &cssHslToQString },
+    { QmlRgbaFormat, "Qt.rgba", QmlRgbaFormat, ANY | QML,
+      &parseQmlRgba<QChar>, &parseQmlRgba<char>, &qmlRgbaToQString },
+    { QmlHslaFormat, "Qt.hsla", QmlHslaFormat, ANY | QML,
+      &parseQmlHsla<QChar>, &parseQmlHsla<char>, &qmlHslaToQString },
+    { GlslFormat, "vec", GlslFormat, ANY | GLSL,
+      &parseGlslColor<QChar>, &parseGlslColor<char>, &glslColorToQString },
+    { HexFormat, "hex", HexFormat, ANY | QSS | CSS,
+      &parseHexColor<QChar>, &parseHexColor<char>, &hexColorToQString },
+    { NamedColorFormat, "name", NamedColorFormat, QSS | CSS,
+      &parseNamedColor<QChar>, &parseNamedColor<char>, &namedColorToQString }
+};
+
+constexpr bool registryFollowsFormats()
+{
+    for (int i = 0; i < COLOR_FORMAT_COUNT; ++i) {
+        if (FORMAT_REGISTRY[i].format != i)
+            return false;
+    }
 
-    const QString COMMA_SEP_STRING = QLatin1String(", ");
+    return true;
+}
 
-    parts = colorDoubleToQString(color.redF()) + COMMA_SEP_STRING
-            + colorDoubleToQString(color.greenF()) + COMMA_SEP_STRING
-            + colorDoubleToQString(color.blueF());
+static_assert(sizeof(FORMAT_REGISTRY) / sizeof(ColorFormatDescriptor) == COLOR_FORMAT_COUNT,
+              "Every format needs an entry in the registry");
+static_assert(registryFollowsFormats(), "The registry must be sorted by format");
 
-    qreal alpha = color.alphaF();
-    if (alpha < 1.0) {
-        prefix.append(QLatin1Char('4'));
-        parts += COMMA_SEP_STRING + colorDoubleToQString(color.alphaF());
-    } else {
-        prefix.append(QLatin1Char('3'));
+constexpr quint32 formatMaskOf(ColorCategory category)
+{
+    quint32 ret = 0;
+
+    for (const ColorFormatDescriptor &descriptor : FORMAT_REGISTRY) {
+        if (descriptor.categories & categoryBit(category))
+            ret |= (1u << descriptor.format);
     }
 
-    prefix.append(QLatin1Char('('));
+    return ret;
+}
 
+constexpr quint32 CATEGORY_FORMAT_MASKS[] =
+{
+    formatMaskOf(AnyCategory),
+    formatMaskOf(QssCategory),
+    formatMaskOf(CssCategory),
+    formatMaskOf(QmlCategory),
+    formatMaskOf(GlslCategory)
+};
+
+inline Utf16Parser parserOf(const ColorFormatDescriptor &descriptor, const QChar *)
+{
+    return descriptor.parseUtf16;
 }
 
-void hexColorToQString(const QColor &color, QString &prefix, QString &parts)
+inline Latin1Parser parserOf(const ColorFormatDescriptor &descriptor, const char *)
 {
-    prefix = QLatin1String("#");
+    return descriptor.parseLatin1;
+}
 
-    int alpha = color.alpha();
+template <typename Char>
+QColor parseScanned(const Char *data, const ColorMatch &scanned)
+{
+    Q_ASSERT(scanned.format < COLOR_FORMAT_COUNT);
 
-    if (alpha < 255)
-        parts.sprintf("%02x%02x%02x%02x",
-                      alpha, color.red(), color.green(), color.blue());
-    else
-        parts.sprintf("%02x%02x%02x",
-                      color.red(), color.green(), color.blue());
+    const ColorFormatDescriptor &descriptor = FORMAT_REGISTRY[scanned.format];
+
+    QColor ret;
+    parserOf(descriptor, data)(ScannedComponents<Char>(data, scanned), ret);
 
-    parts = parts.toUpper();
+    Q_ASSERT_X(ret.isValid(), Q_FUNC_INFO, "The color cannot be invalid.");
+
+    return ret;
 }
 
 } // anon namespace
@@ -289,120 +675,73 @@ namespace Internal {
 
 ColorFormatSet formatsFromCategory(ColorCategory category)
 {
-    ColorFormatSet ret;
+    Q_ASSERT(category >= AnyCategory && category <= GlslCategory);
 
-    switch (category) {
-    case ColorCategory::AnyCategory:
-        ret << QCssRgbUCharFormat << QCssRgbPercentFormat
-            << QssHsvFormat
-            << CssHslFormat
-            << QmlRgbaFormat << QmlHslaFormat
-            << GlslFormat
-            << HexFormat;
-        break;
-    case ColorCategory::QssCategory:
-        ret << QCssRgbUCharFormat << QCssRgbPercentFormat
-            << QssHsvFormat
-            << HexFormat;
-        break;
-    case ColorCategory::CssCategory:
-        ret << QCssRgbUCharFormat << QCssRgbPercentFormat
-            << CssHslFormat
-            << HexFormat;
-        break;
-    case ColorCategory::QmlCategory:
-        ret << QmlRgbaFormat << QmlHslaFormat;
-        break;
-    case ColorCategory::GlslCategory:
-        ret << GlslFormat;
-        break;
-    default:
-        break;
-    }
-
-    Q_ASSERT(ret.size());
-
-    return ret;
+    return ColorFormatSet(CATEGORY_FORMAT_MASKS[category]);
 }
 
-QColor parseColor(ColorFormat format, const QRegularExpressionMatch &match)
+ColorCategory categoryFromFileName(const QString &fileName)
 {
-    QColor ret;
+    const QString suffix = QFileInfo(fileName).suffix().toLower();
 
-    if (format == ColorFormat::QCssRgbUCharFormat) {
-        parseQCssRgbUChar(match, ret);
-    }
-    if (format == ColorFormat::QCssRgbPercentFormat) {
-        parseCssRgbPercent(match, ret);
-    }
-    else if (format == ColorFormat::QssHsvFormat) {
-        parseQssHsv(match, ret);
-    }
-    else if (format == ColorFormat::CssHslFormat) {
-        parseCssHsl(match, ret);
-    }
-    else if (format == ColorFormat::QmlRgbaFormat) {
-        parseQmlRgba(match, ret);
-    }
-    else if (format == ColorFormat::QmlHslaFormat) {
-        parseQmlHsla(match, ret);
-    }
-    else if (format == ColorFormat::GlslFormat) {
-        parseGlslColor(match, ret);
-    }
-    else if (format == ColorFormat::HexFormat) {
-        parseHexColor(match, ret);
-    }
+    if (suffix == QLatin1String("qml") || suffix == QLatin1String("js"))
+        return ColorCategory::QmlCategory;
 
-    Q_ASSERT_X(ret.isValid(), Q_FUNC_INFO, "The color cannot be invalid.");
+    if (suffix == QLatin1String("qss"))
+        return ColorCategory::QssCategory;
 
-    return ret;
+    if (suffix == QLatin1String("css"))
+        return ColorCategory::CssCategory;
+
+    static const QStringList glslSuffixes = {
+        QLatin1String("glsl"), QLatin1String("vert"), QLatin1String("frag"),
+        QLatin1String("geom"), QLatin1String("vsh"), QLatin1String("fsh"),
+        QLatin1String("gsh"), QLatin1String("comp")
+    };
+
+    if (glslSuffixes.contains(suffix))
+        return ColorCategory::GlslCategory;
+
+    return ColorCategory::AnyCategory;
 }
 
-QString colorToString(const QColor &color, ColorFormat format)
+QColor parseColor(const QString &text, const ColorMatch &match)
 {
-    QString ret;
+    return parseScanned(text.constData(), match);
+}
 
-    QString prefix;
-    QString colorParts;
+QColor parseColor(const char *data, const ColorMatch &match)
+{
+    return parseScanned(data, match);
+}
 
-    if (format == ColorFormat::QCssRgbUCharFormat) {
-        cssRgbUCharToQString(color, prefix, colorParts);
-    }
-    if (format == ColorFormat::QCssRgbPercentFormat) {
-        cssRgbPercentToQString(color, prefix, colorParts);
-    }
-    else if (format == ColorFormat::QssHsvFormat) {
-        qssHsvToQString(color, prefix, colorParts);
-    }
-    else if (format == ColorFormat::CssHslFormat) {
-        cssHslToQString(color, prefix, colorParts);
-    }
-    else if (format == ColorFormat::QmlRgbaFormat) {
-        qmlRgbaToQString(color, prefix, colorParts);
-    }
-    else if (format == ColorFormat::QmlHslaFormat) {
-        qmlHslaToQString(color, prefix, colorParts);
-    }
-    else if (format == ColorFormat::GlslFormat) {
-        glslColorToQString(color, prefix, colorParts);
-    }
-    else if (format == ColorFormat::HexFormat) {
-        hexColorToQString(color, prefix, colorParts);
-    }
+QString colorToString(const QColor &color, ColorFormat format, int decimals)
+{
+    Q_ASSERT(format < COLOR_FORMAT_COUNT);
 
-    Q_ASSERT(!prefix.isNull());
-    Q_ASSERT(!colorParts.isNull());
+    ColorWriter writer;
+    FORMAT_REGISTRY[format].toString(color, qBound(MIN_COLOR_DECIMALS, decimals,
+                                                   MAX_COLOR_DECIMALS), writer);
 
-    ret = prefix + colorParts;
+    return writer.toString();
+}
 
-    if (format != ColorFormat::HexFormat)
-        ret += QChar::fromLatin1(')');
+const char *colorFormatButtonLabel(ColorFormat format)
+{
+    return FORMAT_REGISTRY[format].buttonLabel;
+}
 
-    Q_ASSERT_X(!ret.isNull(),
-               Q_FUNC_INFO,"The string version of the color is invalid");
+ColorFormat colorFormatButtonOwner(ColorFormat format)
+{
+    return FORMAT_REGISTRY[format].buttonOwner;
+}
 
-    return ret;
+bool colorsMatch(const QColor &c1, const QColor &c2, int tolerance)
+{
+    return (qAbs(c1.red() - c2.red()) <= tolerance)
+            && (qAbs(c1.green() - c2.green()) <= tolerance)
+            && (qAbs(c1.blue() - c2.blue()) <= tolerance)
+            && (qAbs(c1.alpha() - c2.alpha()) <= tolerance);
 }
 
 } // namespace Internal
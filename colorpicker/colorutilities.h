@@ -3,6 +3,8 @@
 
 #include <QColor>
 #include <QPoint>
+#include <QtAlgorithms>
+#include <QVector>
 
 namespace ColorPicker {
 namespace Internal {
@@ -31,12 +33,61 @@ enum ColorFormat
     // Glsl
     GlslFormat,                 // vec3(1.0, 1.0, 1.0) and vec4(1.0, 1.0, 1.0, 1.0)
     // Others
-    HexFormat                   // #FFFFFFFFFFFF | #FFFFFFFFF | #FFFFFFFF | #FFFFFF | #FFF
+    HexFormat,                  // #FFFFFFFFFFFF | #FFFFFFFFF | #FFFFFFFF | #FFFFFF | #FFF
+    NamedColorFormat            // red, cornflowerblue, transparent
 };
 
-typedef QSet<ColorFormat> ColorFormatSet;
+constexpr int COLOR_FORMAT_COUNT = NamedColorFormat + 1;
 
+// Set of formats stored as a bitmask, bit n being the format n
+class ColorFormatSet
+{
+public:
+    // Walks the formats in increasing order
+    class const_iterator
+    {
+    public:
+        explicit const_iterator(quint32 mask) : m_mask(mask) {}
+
+        ColorFormat operator*() const { return ColorFormat(qCountTrailingZeroBits(m_mask)); }
+        const_iterator &operator++() { m_mask &= (m_mask - 1); return *this; }
+        bool operator!=(const const_iterator &other) const { return m_mask != other.m_mask; }
+
+    private:
+        quint32 m_mask;
+    };
+
+    constexpr ColorFormatSet() : m_mask(0) {}
+    constexpr explicit ColorFormatSet(quint32 mask) : m_mask(mask) {}
+
+    constexpr quint32 mask() const { return m_mask; }
+    constexpr bool isEmpty() const { return !m_mask; }
+    constexpr bool contains(ColorFormat format) const { return (m_mask & (1u << format)) != 0; }
+    int size() const { return int(qPopulationCount(m_mask)); }
+
+    ColorFormatSet &operator<<(ColorFormat format) { m_mask |= (1u << format); return *this; }
+
+    constexpr bool operator==(const ColorFormatSet &other) const { return m_mask == other.m_mask; }
+    constexpr bool operator!=(const ColorFormatSet &other) const { return m_mask != other.m_mask; }
+
+    const_iterator begin() const { return const_iterator(m_mask); }
+    const_iterator end() const { return const_iterator(0); }
+
+private:
+    quint32 m_mask;
+};
+
+static_assert(COLOR_FORMAT_COUNT <= 32, "The format sets are stored in 32 bits");
+
+// Read from the format registry, without building anything
 ColorFormatSet formatsFromCategory(ColorCategory category);
+ColorCategory categoryFromFileName(const QString &fileName);
+
+// Button of the format in the color editor : its label, nullptr when the
+// format is shown by the button of another one (its owner, e.g. the rgb
+// percentages are shown by the rgb button)
+const char *colorFormatButtonLabel(ColorFormat format);
+ColorFormat colorFormatButtonOwner(ColorFormat format);
 
 struct ColorExpr
 {
@@ -45,8 +96,35 @@ struct ColorExpr
     QPoint pos;
 };
 
-QColor parseColor(ColorFormat format, const QRegularExpressionMatch &match);
-QString colorToString(const QColor &color, ColorFormat format);
+struct ColorMatch
+{
+    int end() const { return start + length; }
+
+    ColorFormat format;
+    int start;
+    int length;
+
+    // Components of the expression (e.g. "12" in "rgb(12, 20, 40)"), the
+    // percent sign excluded. The alpha component is the optional 4th one.
+    int capturedCount;
+    int capturedStart[4];
+    int capturedLength[4];
+};
+
+typedef QVector<ColorMatch> ColorMatchList;
+
+QColor parseColor(const QString &text, const ColorMatch &match);
+QColor parseColor(const char *data, const ColorMatch &match);
+// Digits after the dot of the float components (Qt.rgba, vec4, alpha...)
+constexpr int MIN_COLOR_DECIMALS = 1;
+constexpr int MAX_COLOR_DECIMALS = 4;
+constexpr int DEFAULT_COLOR_DECIMALS = 2;
+
+QString colorToString(const QColor &color, ColorFormat format,
+                      int decimals = DEFAULT_COLOR_DECIMALS);
+
+// Whether no 8 bits channel (alpha included) differs by more than tolerance
+bool colorsMatch(const QColor &c1, const QColor &c2, int tolerance);
 
 } // namespace Internal
 } // namespace ColorPicker
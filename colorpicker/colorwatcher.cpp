@@ -5,9 +5,10 @@
 
 // Qt includes
 #include <QDebug> //REMOVEME
-#include <QRegularExpression>
+#include <QMap>
 #include <QTextBlock>
 #include <QTextCursor>
+#include <QTextDocument>
 
 // QtCreator includes
 #include <coreplugin/editormanager/editormanager.h>
@@ -15,7 +16,13 @@
 #include <texteditor/texteditor.h>
 
 // Plugin includes
+#include "colorindex.h"
 #include "colorpickerconstants.h"
+#include "colorscanner.h"
+#include "colortooltip.h"
+#include "colortrace.h"
+
+#include "widgets/colorswatchoverlay.h"
 
 using namespace Core;
 using namespace TextEditor;
@@ -23,45 +30,51 @@ using namespace TextEditor;
 namespace ColorPicker {
 namespace Internal {
 
-static QMultiMap<ColorFormat, QRegularExpression> colorRegexes
-{
-    { ColorFormat::QCssRgbUCharFormat, Constants::REGEX_QCSS_RGB_UCHAR },
-    { ColorFormat::QCssRgbUCharFormat, Constants::REGEX_QCSS_RGBA_UCHAR },
-    { ColorFormat::QCssRgbPercentFormat, Constants::REGEX_QCSS_RGB_PERCENT },
-    { ColorFormat::QCssRgbPercentFormat, Constants::REGEX_QCSS_RGBA_PERCENT },
-    { ColorFormat::QssHsvFormat, Constants::REGEX_QSS_HSV },
-    { ColorFormat::QssHsvFormat, Constants::REGEX_QSS_HSVA },
-    { ColorFormat::CssHslFormat, Constants::REGEX_CSS_HSL },
-    { ColorFormat::CssHslFormat, Constants::REGEX_CSS_HSLA },
-    { ColorFormat::QmlRgbaFormat, Constants::REGEX_QML_RGBA },
-    { ColorFormat::QmlHslaFormat, Constants::REGEX_QML_HSLA },
-    { ColorFormat::GlslFormat, Constants::REGEX_VEC3 },
-    { ColorFormat::GlslFormat, Constants::REGEX_VEC4 },
-    { ColorFormat::HexFormat, Constants::REGEX_HEXCOLOR }
-};
-
 
 ////////////////////////// ColorWatcherImpl //////////////////////////
 
 class ColorWatcherImpl
 {
 public:
-    ColorWatcherImpl();
+    ColorWatcherImpl(ColorWatcher *qq);
     ~ColorWatcherImpl();
 
     /* functions */
     void updateSearchFormats();
 
+    const BlockColors &blockColors(const QTextBlock &block);
+    void invalidateBlocks(int position, int charsRemoved, int charsAdded);
+
+    bool findColorUnderCursor(const QTextCursor &cursor, ColorMatch *match,
+                              QColor *value);
+
     /* variables */
+    ColorWatcher *q;
+
     TextEditor::TextEditorWidget *watched;
     ColorCategory category;
-    ColorFormatSet searchFormats;
+    ColorScanner scanner;
+
+    // QTextBlockUserData is already owned by the text editor (TextBlockUserData),
+    // so the cache lives aside, keyed by block number
+    QMap<int, BlockColors> blockCache;
+    int cachedBlockCount;
+
+    ColorIndex *colorIndex;
+    ColorSwatchOverlay *swatchOverlay;
+    ColorTooltip *tooltip;
 };
 
-ColorWatcherImpl::ColorWatcherImpl() :
+ColorWatcherImpl::ColorWatcherImpl(ColorWatcher *qq) :
+    q(qq),
     watched(nullptr),
     category(ColorCategory::AnyCategory),
-    searchFormats()
+    scanner(),
+    blockCache(),
+    cachedBlockCount(0),
+    colorIndex(nullptr),
+    swatchOverlay(nullptr),
+    tooltip(nullptr)
 {}
 
 ColorWatcherImpl::~ColorWatcherImpl()
@@ -69,7 +82,128 @@ ColorWatcherImpl::~ColorWatcherImpl()
 
 void ColorWatcherImpl::updateSearchFormats()
 {
-    searchFormats = formatsFromCategory(category);
+    scanner.setFormats(formatsFromCategory(category));
+
+    blockCache.clear();
+
+    if (colorIndex)
+        colorIndex->setFormats(scanner.formats());
+
+    if (swatchOverlay)
+        swatchOverlay->update();
+}
+
+const BlockColors &ColorWatcherImpl::blockColors(const QTextBlock &block)
+{
+    const int blockNumber = block.blockNumber();
+
+    auto it = blockCache.find(blockNumber);
+
+    if (it != blockCache.end() && it->revision == block.revision())
+        return *it;
+
+    BlockColors entry;
+    entry.revision = block.revision();
+
+    const QString text = block.text();
+    entry.matches = scanner.scan(text);
+    entry.values.reserve(entry.matches.size());
+
+    for (const ColorMatch &match : entry.matches)
+        entry.values.append(parseColor(text, match));
+
+    const bool wasEmpty = blockCache.isEmpty();
+
+    const BlockColors &ret = *blockCache.insert(blockNumber, entry);
+
+    // Whoever reads the colors (swatches, tooltip, ...), the cache counts again
+    if (wasEmpty)
+        emit q->cacheFilled();
+
+    return ret;
+}
+
+void ColorWatcherImpl::invalidateBlocks(int position, int charsRemoved, int charsAdded)
+{
+    Q_UNUSED(charsRemoved);
+
+    QTextDocument *doc = watched->document();
+
+    const int blockCount = doc->blockCount();
+    const int blockCountDelta = blockCount - cachedBlockCount;
+    cachedBlockCount = blockCount;
+
+    if (blockCache.isEmpty())
+        return;
+
+    // Blocks [first, lastAfter] now cover what was [first, lastBefore]
+    const int first = doc->findBlock(position).blockNumber();
+    const int lastAfter = doc->findBlock(position + charsAdded).blockNumber();
+    const int lastBefore = lastAfter - blockCountDelta;
+
+    auto it = blockCache.lowerBound(first);
+
+    if (!blockCountDelta) {
+        while (it != blockCache.end() && it.key() <= lastBefore)
+            it = blockCache.erase(it);
+
+        return;
+    }
+
+    // Renumber the blocks that follow the change
+    QMap<int, BlockColors> shifted;
+
+    while (it != blockCache.end()) {
+        if (it.key() > lastBefore)
+            shifted.insert(it.key() + blockCountDelta, it.value());
+
+        it = blockCache.erase(it);
+    }
+
+    for (auto sIt = shifted.cbegin(); sIt != shifted.cend(); ++sIt)
+        blockCache.insert(sIt.key(), sIt.value());
+}
+
+bool ColorWatcherImpl::findColorUnderCursor(const QTextCursor &cursor, ColorMatch *match,
+                                            QColor *value)
+{
+    QTextBlock block = cursor.block();
+    int cursorPosInLine = cursor.positionInBlock();
+
+    // On huge lines (e.g. minified stylesheets), only look around the cursor
+    if (block.length() > Constants::WINDOWED_DETECTION_MIN_LINE_LENGTH) {
+        int windowStart = qMax(0, cursorPosInLine - Constants::GRAMMAR_MAX_EXPRESSION_LENGTH);
+        int windowEnd = qMin(block.length() - 1,
+                             cursorPosInLine + Constants::GRAMMAR_MAX_EXPRESSION_LENGTH);
+
+        QTextCursor windowCursor(block);
+        windowCursor.setPosition(block.position() + windowStart);
+        windowCursor.setPosition(block.position() + windowEnd, QTextCursor::KeepAnchor);
+
+        const QString windowText = windowCursor.selectedText();
+
+        if (!scanner.matchAround(windowText, cursorPosInLine - windowStart, match))
+            return false;
+
+        *value = parseColor(windowText, *match);
+        match->start += windowStart;
+
+        for (int i = 0; i < match->capturedCount; ++i)
+            match->capturedStart[i] += windowStart;
+
+        return true;
+    }
+
+    const BlockColors &colors = blockColors(block);
+
+    const int index = findMatchAt(colors.matches, cursorPosInLine);
+    if (index < 0)
+        return false;
+
+    *match = colors.matches.at(index);
+    *value = colors.values.at(index);
+
+    return true;
 }
 
 
@@ -77,12 +211,20 @@ void ColorWatcherImpl::updateSearchFormats()
 
 ColorWatcher::ColorWatcher(TextEditorWidget *textEditor) :
     QObject(textEditor),
-    d(new ColorWatcherImpl)
+    d(new ColorWatcherImpl(this))
 {
     Q_ASSERT_X(textEditor, Q_FUNC_INFO, "ColorPickerPlugin > The text editor is invalid.");
     d->watched = textEditor;
 
     d->updateSearchFormats();
+
+    QTextDocument *doc = textEditor->document();
+    d->cachedBlockCount = doc->blockCount();
+
+    connect(doc, &QTextDocument::contentsChange,
+            this, [=](int position, int charsRemoved, int charsAdded) {
+        d->invalidateBlocks(position, charsRemoved, charsAdded);
+    });
 }
 
 ColorWatcher::~ColorWatcher()
@@ -104,65 +246,164 @@ void ColorWatcher::setColorCategory(ColorCategory category)
     }
 }
 
+BlockColors ColorWatcher::colorsInBlock(const QTextBlock &block)
+{
+    return d->blockColors(block);
+}
+
+ColorIndex *ColorWatcher::colorIndex()
+{
+    if (!d->colorIndex) {
+        d->colorIndex = new ColorIndex(d->watched->document(), d->scanner.formats(), this);
+
+        emit cacheFilled();
+    }
+
+    return d->colorIndex;
+}
+
+QVector<ColorIndexEntry> ColorWatcher::colorsInDocument()
+{
+    ColorIndex *index = colorIndex();
+
+    if (index->isReady())
+        return index->entries();
+
+    QVector<ColorIndexEntry> ret;
+
+    QTextDocument *doc = d->watched->document();
+
+    for (QTextBlock block = doc->begin(); block.isValid(); block = block.next()) {
+        const BlockColors &colors = d->blockColors(block);
+
+        for (int i = 0; i < colors.matches.size(); ++i) {
+            const ColorMatch &match = colors.matches.at(i);
+
+            ColorIndexEntry entry;
+            entry.offset = block.position() + match.start;
+            entry.length = match.length;
+            entry.format = match.format;
+            entry.value = colors.values.at(i);
+
+            ret.append(entry);
+        }
+    }
+
+    return ret;
+}
+
 ColorExpr ColorWatcher::process()
 {
+    TraceSpan span("ColorWatcher::process");
+
     ColorExpr ret;
 
     QTextCursor currentCursor = d->watched->textCursor();
     QRect cursorRect = d->watched->cursorRect();
 
     // Search for a color pattern
-    QString lineText = currentCursor.block().text();
+    ColorMatch match;
+    QColor color;
+
+    if (d->findColorUnderCursor(currentCursor, &match, &color)) {
+        int cursorPosInLine = currentCursor.positionInBlock();
+        int capturedStart = match.start;
+        int capturedEnd = match.end();
+
+        // If a part of the selection is already selected, deselect it
+        if (currentCursor.hasSelection())
+            currentCursor.clearSelection();
+
+        // Select the expression
+        currentCursor.movePosition(QTextCursor::Left, QTextCursor::MoveAnchor,
+                                   cursorPosInLine - capturedStart);
+        cursorRect.setLeft(d->watched->cursorRect(currentCursor).left());
+        currentCursor.movePosition(QTextCursor::Right, QTextCursor::KeepAnchor,
+                                   capturedEnd - capturedStart);
+        cursorRect.setRight(d->watched->cursorRect(currentCursor).right());
+
+        d->watched->setTextCursor(currentCursor);
+
+        ret.format = match.format;
+        ret.value = color;
+    }
 
-    for (auto it = colorRegexes.begin(); it != colorRegexes.end(); ++it) {
-        ColorFormat format = it.key();
+    ret.pos = QPoint(cursorRect.center().x(),
+                     cursorRect.bottom() + 2);
 
-        if (!d->searchFormats.contains(format))
-            continue;
+    return ret;
+}
 
-        QRegularExpressionMatchIterator matchIt = it.value().globalMatch(lineText);
+bool ColorWatcher::swatchesVisible() const
+{
+    return (d->swatchOverlay && d->swatchOverlay->isVisible());
+}
 
-        if (matchIt.hasNext()) {
-            QRegularExpressionMatch match = matchIt.next();
+void ColorWatcher::setSwatchesVisible(bool visible)
+{
+    if (!d->swatchOverlay) {
+        if (!visible)
+            return;
+
+        d->swatchOverlay = new ColorSwatchOverlay(d->watched, this);
+
+        connect(d->swatchOverlay, &ColorSwatchOverlay::swatchClicked,
+                this, [=](int position, int length) {
+            QTextCursor cursor(d->watched->document());
+            cursor.setPosition(position);
+            cursor.setPosition(position + length, QTextCursor::KeepAnchor);
 
-            int cursorPosInLine = currentCursor.positionInBlock();
-            int capturedStart =  match.capturedStart();
-            int capturedEnd =  match.capturedEnd();
+            // Makes the editor the current one
+            d->watched->setFocus();
+            d->watched->setTextCursor(cursor);
 
-            bool cursorIsUnderColor = (cursorPosInLine >= capturedStart) &&
-                    (cursorPosInLine <= capturedEnd);
+            emit swatchClicked();
+        });
+    }
+
+    d->swatchOverlay->setVisible(visible);
+}
 
-            if (cursorIsUnderColor) {
-                // If a part of the selection is already selected, deselect it
-                if (currentCursor.hasSelection())
-                    currentCursor.clearSelection();
+bool ColorWatcher::tooltipsEnabled() const
+{
+    return (d->tooltip && d->tooltip->isEnabled());
+}
 
-                // Select the expression
-                currentCursor.movePosition(QTextCursor::Left, QTextCursor::MoveAnchor,
-                                           cursorPosInLine - capturedStart);
-                cursorRect.setLeft(d->watched->cursorRect(currentCursor).left());
-                currentCursor.movePosition(QTextCursor::Right, QTextCursor::KeepAnchor,
-                                           capturedEnd - capturedStart);
-                cursorRect.setRight(d->watched->cursorRect(currentCursor).right());
+void ColorWatcher::setTooltipsEnabled(bool enabled)
+{
+    if (!d->tooltip) {
+        if (!enabled)
+            return;
 
-                d->watched->setTextCursor(currentCursor);
+        d->tooltip = new ColorTooltip(d->watched, this);
+    }
 
-                //
-                QColor color = parseColor(format, match);
+    d->tooltip->setEnabled(enabled);
+}
 
-                ret.format = format;
-                ret.value = color;
+qint64 ColorWatcher::cacheMemory() const
+{
+    qint64 ret = 0;
 
-                break;
-            }
-        }
+    for (const BlockColors &colors : d->blockCache) {
+        ret += sizeof(int) + sizeof(BlockColors);
+        ret += colors.matches.capacity() * sizeof(ColorMatch);
+        ret += colors.values.capacity() * sizeof(QColor);
     }
 
-    ret.pos = QPoint(cursorRect.center().x(),
-                     cursorRect.bottom() + 2);
+    if (d->colorIndex)
+        ret += d->colorIndex->entries().size() * sizeof(ColorIndexEntry);
 
     return ret;
 }
 
+void ColorWatcher::releaseCache()
+{
+    d->blockCache.clear();
+
+    delete d->colorIndex;
+    d->colorIndex = nullptr;
+}
+
 } // namespace Internal
 } // namespace ColorPicker
@@ -5,6 +5,8 @@
 
 #include "colorutilities.h"
 
+class QTextBlock;
+
 namespace TextEditor {
 class TextEditorWidget;
 }
@@ -12,8 +14,20 @@ class TextEditorWidget;
 namespace ColorPicker {
 namespace Internal {
 
+class ColorIndex;
+class ColorSwatchOverlay;
+class ColorTooltip;
+struct ColorIndexEntry;
 class ColorWatcherImpl;
 
+// Colors found in a text block, positions are relative to the block
+struct BlockColors
+{
+    int revision;
+    ColorMatchList matches;
+    QVector<QColor> values;
+};
+
 class ColorWatcher : public QObject
 {
     Q_OBJECT
@@ -25,8 +39,40 @@ public:
     ColorCategory colorCategory() const;
     void setColorCategory(ColorCategory category);
 
+    // Served from a per-block cache, invalidated when the block changes
+    BlockColors colorsInBlock(const QTextBlock &block);
+
+    // Whole-document index, built in the background on first use
+    ColorIndex *colorIndex();
+
+    // Colors of the whole document, read from the index. While the index is
+    // being built, the document is scanned right now through the block cache.
+    QVector<ColorIndexEntry> colorsInDocument();
+
     ColorExpr process();
 
+    // Swatches drawn next to the colors of the visible lines
+    bool swatchesVisible() const;
+    void setSwatchesVisible(bool visible);
+
+    // Tooltip showing the color under the mouse
+    bool tooltipsEnabled() const;
+    void setTooltipsEnabled(bool enabled);
+
+    // Approximate size of the cached colors, in bytes
+    qint64 cacheMemory() const;
+
+    // Frees the cached colors, scanned again when needed
+    void releaseCache();
+
+signals:
+    // The expression is selected in the watched editor, which may not be the
+    // current one
+    void swatchClicked();
+
+    // The cache was empty (e.g. released) and colors are cached again
+    void cacheFilled();
+
 private:
     QScopedPointer<ColorWatcherImpl> d;
 };
@@ -4,16 +4,30 @@
 
 #include <utils/settingsutils.h>
 
+#include "colorutilities.h"
+
 namespace ColorPicker {
 namespace Internal {
 
 static const char groupPostfix[] = "GeneralSettings";
 static const char editorSensitiveKey[] = "EditorSensitive";
 static const char insertOnChangeKey[] = "InsertOnChange";
+static const char previewChangesKey[] = "PreviewChanges";
+static const char replaceToleranceKey[] = "ReplaceTolerance";
+static const char showSwatchesKey[] = "ShowSwatches";
+static const char showTooltipsKey[] = "ShowTooltips";
+static const char qmlDecimalsKey[] = "QmlDecimals";
+static const char glslDecimalsKey[] = "GlslDecimals";
 
 GeneralSettings::GeneralSettings() :
     m_editorSensitive(true),
-    m_insertOnChange(true)
+    m_insertOnChange(true),
+    m_previewChanges(false),
+    m_replaceTolerance(0),
+    m_showSwatches(true),
+    m_showTooltips(true),
+    m_qmlDecimals(DEFAULT_COLOR_DECIMALS),
+    m_glslDecimals(DEFAULT_COLOR_DECIMALS)
 {}
 
 void GeneralSettings::toSettings(const QString &category, QSettings *s) const
@@ -31,6 +45,12 @@ void GeneralSettings::toMap(const QString &prefix, QVariantMap *map) const
 {
     map->insert(prefix + QLatin1String(editorSensitiveKey), m_editorSensitive);
     map->insert(prefix + QLatin1String(insertOnChangeKey), m_insertOnChange);
+    map->insert(prefix + QLatin1String(previewChangesKey), m_previewChanges);
+    map->insert(prefix + QLatin1String(replaceToleranceKey), m_replaceTolerance);
+    map->insert(prefix + QLatin1String(showSwatchesKey), m_showSwatches);
+    map->insert(prefix + QLatin1String(showTooltipsKey), m_showTooltips);
+    map->insert(prefix + QLatin1String(qmlDecimalsKey), m_qmlDecimals);
+    map->insert(prefix + QLatin1String(glslDecimalsKey), m_glslDecimals);
 }
 
 void GeneralSettings::fromMap(const QString &prefix, const QVariantMap &map)
@@ -39,6 +59,18 @@ void GeneralSettings::fromMap(const QString &prefix, const QVariantMap &map)
                                   m_editorSensitive).toBool();
     m_insertOnChange = map.value(prefix + QLatin1String(insertOnChangeKey),
                                  m_insertOnChange).toBool();
+    m_previewChanges = map.value(prefix + QLatin1String(previewChangesKey),
+                                 m_previewChanges).toBool();
+    m_replaceTolerance = map.value(prefix + QLatin1String(replaceToleranceKey),
+                                   m_replaceTolerance).toInt();
+    m_showSwatches = map.value(prefix + QLatin1String(showSwatchesKey),
+                               m_showSwatches).toBool();
+    m_showTooltips = map.value(prefix + QLatin1String(showTooltipsKey),
+                               m_showTooltips).toBool();
+    m_qmlDecimals = map.value(prefix + QLatin1String(qmlDecimalsKey),
+                              m_qmlDecimals).toInt();
+    m_glslDecimals = map.value(prefix + QLatin1String(glslDecimalsKey),
+                               m_glslDecimals).toInt();
 }
 
 bool GeneralSettings::equals(const GeneralSettings &gs) const
@@ -49,6 +81,24 @@ bool GeneralSettings::equals(const GeneralSettings &gs) const
     if (m_insertOnChange != gs.m_insertOnChange)
         return false;
 
+    if (m_previewChanges != gs.m_previewChanges)
+        return false;
+
+    if (m_replaceTolerance != gs.m_replaceTolerance)
+        return false;
+
+    if (m_showSwatches != gs.m_showSwatches)
+        return false;
+
+    if (m_showTooltips != gs.m_showTooltips)
+        return false;
+
+    if (m_qmlDecimals != gs.m_qmlDecimals)
+        return false;
+
+    if (m_glslDecimals != gs.m_glslDecimals)
+        return false;
+
     return true;
 }
 
@@ -24,6 +24,12 @@ public:
     /* variables */
     bool m_editorSensitive;
     bool m_insertOnChange;
+    bool m_previewChanges;      // Drawn over the text, written once when the edit ends
+    int m_replaceTolerance;     // Per channel, 0-255
+    bool m_showSwatches;
+    bool m_showTooltips;
+    int m_qmlDecimals;          // Qt.rgba() and Qt.hsla(), 1-4
+    int m_glslDecimals;         // vec3() and vec4(), 1-4
 };
 
 inline bool operator==(const GeneralSettings &t1, const GeneralSettings &t2) { return t1.equals(t2); }
@@ -0,0 +1,290 @@
+#include "projectcolorscanner.h"
+
+// std includes
+#include <cstring>
+
+// Qt includes
+#include <QDateTime>
+#include <QFile>
+#include <QFileInfo>
+#include <QSet>
+#include <QFutureWatcher>
+#include <QtConcurrentMap>
+
+namespace {
+
+using namespace ColorPicker::Internal;
+
+// Bigger files are generated data, not style sheets
+const qint64 MAX_FILE_SIZE = 16 * 1024 * 1024;
+
+// A NUL byte in the first bytes means the file is binary
+const int BINARY_PROBE_SIZE = 1024;
+
+quint64 hashData(const char *data, qint64 size)
+{
+    quint64 ret = Q_UINT64_C(14695981039346656037);
+
+    for (qint64 i = 0; i < size; ++i) {
+        ret ^= uchar(data[i]);
+        ret *= Q_UINT64_C(1099511628211);
+    }
+
+    return ret;
+}
+
+bool isBinary(const char *data, qint64 size)
+{
+    const size_t probeSize = size_t(qMin<qint64>(size, BINARY_PROBE_SIZE));
+
+    return std::memchr(data, '\0', probeSize) != nullptr;
+}
+
+void scanData(const QString &fileName, const char *data, int size,
+              const ColorScanner &scanner, ColorOccurrences &occurrences)
+{
+    int lineNumber = 1;
+    int lineStart = 0;
+
+    while (lineStart <= size) {
+        auto newline = static_cast<const char *>(std::memchr(data + lineStart, '\n',
+                                                             size_t(size - lineStart)));
+        const int lineEnd = (newline) ? int(newline - data) : size;
+
+        const ColorMatchList matches = scanner.scan(data, lineStart, lineEnd);
+
+        for (const ColorMatch &match : matches) {
+            ColorOccurrence occurrence;
+            occurrence.fileName = fileName;
+            occurrence.line = lineNumber;
+            occurrence.column = match.start - lineStart + 1;
+            occurrence.offset = match.start;
+            occurrence.length = match.length;
+            occurrence.format = match.format;
+            occurrence.value = parseColor(data, match);
+
+            occurrences.append(occurrence);
+        }
+
+        lineStart = lineEnd + 1;
+        ++lineNumber;
+    }
+}
+
+// Picks the scanner of the file category, as formatsFromCategory() does for
+// the editors. The previous stamps are read from a copy of the inventory, which
+// shares its mapped index file.
+class ScanFile
+{
+public:
+    typedef FileColors result_type;
+
+    ScanFile(const ColorInventory &previous) :
+        m_scanners(),
+        m_previous(previous)
+    {
+        const ColorCategory categories[] = {
+            AnyCategory, QssCategory, CssCategory, QmlCategory, GlslCategory
+        };
+
+        for (ColorCategory category : categories)
+            m_scanners[category] = ColorScanner(formatsFromCategory(category));
+    }
+
+    FileColors operator()(const QString &fileName) const
+    {
+        FileStamp previous;
+        const bool known = m_previous.stamp(fileName, &previous);
+
+        return scanFileColors(fileName, m_scanners[categoryFromFileName(fileName)],
+                              (known) ? &previous : nullptr);
+    }
+
+private:
+    ColorScanner m_scanners[GlslCategory + 1];
+    ColorInventory m_previous;
+};
+
+} // anon namespace
+
+namespace ColorPicker {
+namespace Internal {
+
+
+////////////////////////// ProjectColorScannerImpl //////////////////////////
+
+class ProjectColorScannerImpl
+{
+public:
+    ProjectColorScannerImpl(ProjectColorScanner *qq);
+
+    /* functions */
+    void onResultReadyAt(int index);
+
+    /* variables */
+    ProjectColorScanner *q;
+
+    QFutureWatcher<FileColors> watcher;
+    ColorInventory inventory;
+    int rescannedFileCount;
+};
+
+ProjectColorScannerImpl::ProjectColorScannerImpl(ProjectColorScanner *qq) :
+    q(qq),
+    watcher(),
+    inventory(),
+    rescannedFileCount(0)
+{}
+
+void ProjectColorScannerImpl::onResultReadyAt(int index)
+{
+    const FileColors result = watcher.resultAt(index);
+
+    if (result.unchanged) {
+        inventory.setStamp(result.fileName, result.stamp);
+    }
+    else {
+        inventory.addFile(result);
+        ++rescannedFileCount;
+    }
+
+    emit q->fileScanned(result.fileName);
+}
+
+
+////////////////////////// ProjectColorScanner //////////////////////////
+
+ProjectColorScanner::ProjectColorScanner(QObject *parent) :
+    QObject(parent),
+    d(new ProjectColorScannerImpl(this))
+{
+    connect(&d->watcher, &QFutureWatcher<FileColors>::resultReadyAt,
+            this, [=](int index) { d->onResultReadyAt(index); });
+
+    // A canceled scan is abandoned, not finished
+    connect(&d->watcher, &QFutureWatcher<FileColors>::finished,
+            this, [=]() {
+        if (!d->watcher.isCanceled())
+            emit finished();
+    });
+}
+
+ProjectColorScanner::~ProjectColorScanner()
+{
+    // The plugin code must not run after it is unloaded
+    d->watcher.cancel();
+    d->watcher.waitForFinished();
+}
+
+QFuture<FileColors> ProjectColorScanner::start(const QStringList &fileNames)
+{
+    cancel();
+
+    // Forget the files that left the project
+    const QSet<QString> fileNameSet = fileNames.toSet();
+
+    for (const QString &fileName : d->inventory.fileNames()) {
+        if (!fileNameSet.contains(fileName))
+            d->inventory.removeFile(fileName);
+    }
+
+    d->rescannedFileCount = 0;
+
+    QFuture<FileColors> future = QtConcurrent::mapped(fileNames, ScanFile(d->inventory));
+    d->watcher.setFuture(future);
+
+    return future;
+}
+
+void ProjectColorScanner::cancel()
+{
+    // Not waited for : the results still pending are dropped by the watcher,
+    // and the files being scanned finish on the pool with their own copies
+    d->watcher.cancel();
+}
+
+bool ProjectColorScanner::isRunning() const
+{
+    return d->watcher.isRunning();
+}
+
+const ColorInventory &ProjectColorScanner::inventory() const
+{
+    return d->inventory;
+}
+
+int ProjectColorScanner::rescannedFileCount() const
+{
+    return d->rescannedFileCount;
+}
+
+bool ProjectColorScanner::loadIndex(const QString &indexFileName)
+{
+    cancel();
+
+    return d->inventory.load(indexFileName);
+}
+
+bool ProjectColorScanner::saveIndex(const QString &indexFileName)
+{
+    return d->inventory.save(indexFileName);
+}
+
+FileColors scanFileColors(const QString &fileName, const ColorScanner &scanner,
+                          const FileStamp *previous)
+{
+    FileColors ret;
+    ret.fileName = fileName;
+    ret.unchanged = false;
+
+    const QFileInfo info(fileName);
+
+    ret.stamp.modified = info.lastModified().toMSecsSinceEpoch();
+    ret.stamp.size = info.size();
+    ret.stamp.hash = 0;
+
+    // Same date and size, trust the previous scan without reading the file
+    if (previous && previous->modified == ret.stamp.modified
+            && previous->size == ret.stamp.size) {
+        ret.stamp.hash = previous->hash;
+        ret.unchanged = true;
+        return ret;
+    }
+
+    QFile file(fileName);
+
+    if (!file.open(QIODevice::ReadOnly))
+        return ret;
+
+    qint64 size = file.size();
+
+    if (size == 0 || size > MAX_FILE_SIZE)
+        return ret;
+
+    // Mapping avoids copying the file, reading is only the fallback
+    // for the file systems that cannot map
+    QByteArray contents;
+    const char *data = reinterpret_cast<const char *>(file.map(0, size));
+
+    if (!data) {
+        contents = file.readAll();
+        data = contents.constData();
+        size = contents.size();
+    }
+
+    // Only touched, the contents are the same
+    ret.stamp.hash = hashData(data, size);
+
+    if (previous && previous->size == size && previous->hash == ret.stamp.hash) {
+        ret.unchanged = true;
+        return ret;
+    }
+
+    if (!isBinary(data, size))
+        scanData(fileName, data, int(size), scanner, ret.occurrences);
+
+    return ret;
+}
+
+} // namespace Internal
+} // namespace ColorPicker
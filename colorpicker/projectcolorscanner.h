@@ -0,0 +1,54 @@
+#ifndef PROJECTCOLORSCANNER_H
+#define PROJECTCOLORSCANNER_H
+
+#include <QFuture>
+#include <QObject>
+
+#include "colorinventory.h"
+#include "colorscanner.h"
+
+namespace ColorPicker {
+namespace Internal {
+
+class ProjectColorScannerImpl;
+
+// Collects the colors of many files at once. Each file is mapped in memory and
+// scanned on the global thread pool with the formats of its category, and the
+// results are merged into the inventory as soon as they arrive. Files whose
+// stamp did not change since the previous scan are skipped.
+class ProjectColorScanner : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit ProjectColorScanner(QObject *parent = nullptr);
+    ~ProjectColorScanner();
+
+    QFuture<FileColors> start(const QStringList &fileNames);
+    void cancel();
+
+    bool isRunning() const;
+
+    const ColorInventory &inventory() const;
+    int rescannedFileCount() const;
+
+    bool loadIndex(const QString &indexFileName);
+    bool saveIndex(const QString &indexFileName);
+
+signals:
+    void fileScanned(const QString &fileName);
+    void finished();
+
+private:
+    QScopedPointer<ProjectColorScannerImpl> d;
+};
+
+// Scans a single file, positions of the occurrences are byte offsets. When the
+// contents still match the previous stamp, the file is only flagged unchanged.
+FileColors scanFileColors(const QString &fileName, const ColorScanner &scanner,
+                          const FileStamp *previous = nullptr);
+
+} // namespace Internal
+} // namespace ColorPicker
+
+#endif // PROJECTCOLORSCANNER_H
@@ -0,0 +1,346 @@
+#include "projectrecolor.h"
+
+// std includes
+#include <algorithm>
+
+// Qt includes
+#include <QFile>
+#include <QFutureWatcher>
+#include <QMap>
+#include <QPointer>
+#include <QSharedPointer>
+#include <QStringList>
+#include <QtConcurrentMap>
+
+// QtCreator includes
+#include <coreplugin/find/searchresultwindow.h>
+
+#include <texteditor/refactoringchanges.h>
+#include <utils/changeset.h>
+
+// Plugin includes
+#include "colorscanner.h"
+#include "projectcolorscanner.h"
+
+using namespace Core;
+using namespace TextEditor;
+
+namespace {
+
+using namespace ColorPicker::Internal;
+
+// Finds the expressions of a file that match one of the source colors
+class FindProposals
+{
+public:
+    typedef RecolorProposals result_type;
+
+    FindProposals(const QVector<QColor> &sourceColors, int tolerance) :
+        m_scanners(),
+        m_sourceColors(sourceColors),
+        m_tolerance(tolerance)
+    {
+        const ColorCategory categories[] = {
+            AnyCategory, QssCategory, CssCategory, QmlCategory, GlslCategory
+        };
+
+        for (ColorCategory category : categories)
+            m_scanners[category] = ColorScanner(formatsFromCategory(category));
+    }
+
+    RecolorProposals operator()(const QString &fileName) const
+    {
+        RecolorProposals ret;
+
+        const FileColors colors = scanFileColors(fileName,
+                                                 m_scanners[categoryFromFileName(fileName)]);
+
+        ColorOccurrences matched;
+
+        for (const ColorOccurrence &occurrence : colors.occurrences) {
+            if (matchesSource(occurrence.value))
+                matched.append(occurrence);
+        }
+
+        if (matched.isEmpty())
+            return ret;
+
+        // Few files get here, reading them again for the preview costs little
+        QFile file(fileName);
+        if (!file.open(QIODevice::ReadOnly))
+            return ret;
+
+        const QByteArray contents = file.readAll();
+        const char *data = contents.constData();
+
+        for (const ColorOccurrence &occurrence : matched) {
+            // The file changed in the meantime
+            if (occurrence.offset + occurrence.length > contents.size())
+                continue;
+
+            const int lineStart = occurrence.offset - (occurrence.column - 1);
+
+            int lineEnd = contents.indexOf('\n', occurrence.offset);
+            if (lineEnd < 0)
+                lineEnd = contents.size();
+
+            if (lineEnd > lineStart && data[lineEnd - 1] == '\r')
+                --lineEnd;
+
+            RecolorProposal proposal;
+            proposal.fileName = fileName;
+            proposal.line = occurrence.line;
+            proposal.column = QString::fromUtf8(data + lineStart, occurrence.column - 1).size() + 1;
+            proposal.lineText = QString::fromUtf8(data + lineStart, lineEnd - lineStart);
+            proposal.oldText = QString::fromLatin1(data + occurrence.offset, occurrence.length);
+            proposal.format = occurrence.format;
+
+            ret.append(proposal);
+        }
+
+        return ret;
+    }
+
+private:
+    bool matchesSource(const QColor &color) const
+    {
+        for (const QColor &source : m_sourceColors) {
+            if (colorsMatch(color, source, m_tolerance))
+                return true;
+        }
+
+        return false;
+    }
+
+    ColorScanner m_scanners[GlslCategory + 1];
+    QVector<QColor> m_sourceColors;
+    int m_tolerance;
+};
+
+} // anon namespace
+
+namespace ColorPicker {
+namespace Internal {
+
+
+////////////////////////// ProjectRecolorImpl //////////////////////////
+
+// What a search applies. Older searches stay in the Search Results history
+// and can still be applied, each one keeps its own proposals.
+struct RecolorSearch
+{
+    RecolorProposals proposals;     // Indexed by the user data of the results
+    QColor targetColor;
+};
+
+typedef QSharedPointer<RecolorSearch> RecolorSearchPtr;
+
+class ProjectRecolorImpl
+{
+public:
+    ProjectRecolorImpl(ProjectRecolor *qq);
+
+    /* functions */
+    void onResultReadyAt(int index);
+    void onFinished();
+
+    void apply(const RecolorSearch &recolorSearch, const QString &replaceText,
+               const QList<SearchResultItem> &items);
+
+    /* variables */
+    ProjectRecolor *q;
+
+    QFutureWatcher<RecolorProposals> watcher;
+    QPointer<SearchResult> search;
+    RecolorSearchPtr current;
+    bool searching;                 // The current search is not finished yet
+
+    int decimals[COLOR_FORMAT_COUNT];
+};
+
+ProjectRecolorImpl::ProjectRecolorImpl(ProjectRecolor *qq) :
+    q(qq),
+    watcher(),
+    search(),
+    current(new RecolorSearch),
+    searching(false)
+{
+    std::fill_n(decimals, COLOR_FORMAT_COUNT, DEFAULT_COLOR_DECIMALS);
+}
+
+void ProjectRecolorImpl::onResultReadyAt(int index)
+{
+    if (!search)
+        return;
+
+    RecolorProposals &proposals = current->proposals;
+
+    for (const RecolorProposal &proposal : watcher.resultAt(index)) {
+        search->addResult(proposal.fileName, proposal.line, proposal.lineText,
+                          proposal.column - 1, proposal.oldText.size(),
+                          QVariant(proposals.size()));
+
+        proposals.append(proposal);
+    }
+}
+
+void ProjectRecolorImpl::onFinished()
+{
+    searching = false;
+
+    if (search)
+        search->finishSearch(watcher.isCanceled());
+}
+
+void ProjectRecolorImpl::apply(const RecolorSearch &recolorSearch, const QString &replaceText,
+                               const QList<SearchResultItem> &items)
+{
+    const RecolorProposals &proposals = recolorSearch.proposals;
+
+    // The replacement may have been edited in the Search Results pane
+    const QString trimmedText = replaceText.trimmed();
+
+    QMap<QString, QList<int> > proposalsByFile;
+
+    for (const SearchResultItem &item : items) {
+        bool ok = false;
+        const int index = item.userData.toInt(&ok);
+
+        if (ok && index >= 0 && index < proposals.size())
+            proposalsByFile[proposals.at(index).fileName].append(index);
+    }
+
+    RefactoringChanges changes;
+    int replacementCount = 0;
+    int fileCount = 0;
+
+    for (auto it = proposalsByFile.cbegin(); it != proposalsByFile.cend(); ++it) {
+        RefactoringFilePtr file = changes.file(it.key());
+        Utils::ChangeSet changeSet;
+
+        const ColorScanner scanner(formatsFromCategory(categoryFromFileName(it.key())));
+        QColor newColor = recolorSearch.targetColor;
+        ColorMatch match;
+
+        if (scanner.matchAt(trimmedText, 0, &match))
+            newColor = parseColor(trimmedText, match);
+
+        for (int index : it.value()) {
+            const RecolorProposal &proposal = proposals.at(index);
+
+            const int start = file->position(unsigned(proposal.line), unsigned(proposal.column));
+            const int end = start + proposal.oldText.size();
+
+            // Skip what was edited since the scan
+            if (file->textOf(start, end) != proposal.oldText)
+                continue;
+
+            changeSet.replace(start, end, colorToString(newColor, proposal.format,
+                                                        decimals[proposal.format]));
+            ++replacementCount;
+        }
+
+        if (changeSet.isEmpty())
+            continue;
+
+        file->setChangeSet(changeSet);
+        file->apply();
+        ++fileCount;
+    }
+
+    SearchResultWindow::instance()->hide();
+
+    emit q->applied(replacementCount, fileCount);
+}
+
+
+////////////////////////// ProjectRecolor //////////////////////////
+
+ProjectRecolor::ProjectRecolor(QObject *parent) :
+    QObject(parent),
+    d(new ProjectRecolorImpl(this))
+{
+    connect(&d->watcher, &QFutureWatcher<RecolorProposals>::resultReadyAt,
+            this, [=](int index) { d->onResultReadyAt(index); });
+
+    connect(&d->watcher, &QFutureWatcher<RecolorProposals>::finished,
+            this, [=]() { d->onFinished(); });
+}
+
+ProjectRecolor::~ProjectRecolor()
+{
+    d->watcher.cancel();
+    d->watcher.waitForFinished();
+}
+
+QFuture<RecolorProposals> ProjectRecolor::start(const QStringList &fileNames,
+                                                const QVector<QColor> &sourceColors,
+                                                const QColor &targetColor, int tolerance)
+{
+    cancel();
+
+    // Its pending results and end are dropped along with the old future
+    if (d->search && d->searching)
+        d->search->finishSearch(true);
+
+    RecolorSearchPtr recolorSearch(new RecolorSearch);
+    recolorSearch->targetColor = targetColor;
+    d->current = recolorSearch;
+
+    QStringList sourceTexts;
+
+    for (const QColor &color : sourceColors)
+        sourceTexts << colorToString(color, HexFormat);
+
+    SearchResultWindow *window = SearchResultWindow::instance();
+
+    d->search = window->startNewSearch(tr("Recolor"), QString(),
+                                       sourceTexts.join(QLatin1String(", ")),
+                                       SearchResultWindow::SearchAndReplace,
+                                       SearchResultWindow::PreserveCaseDisabled);
+    d->search->setTextToReplace(colorToString(targetColor, HexFormat));
+
+    SearchResult *search = d->search.data();
+
+    connect(search, &SearchResult::replaceButtonClicked,
+            this, [=](const QString &replaceText, const QList<SearchResultItem> &items) {
+        d->apply(*recolorSearch, replaceText, items);
+    });
+
+    // An older search of the history has no scan left to cancel
+    connect(search, &SearchResult::cancelled,
+            this, [=]() {
+        if (d->search == search)
+            cancel();
+    });
+
+    window->popup(IOutputPane::ModeSwitch | IOutputPane::WithFocus);
+
+    QFuture<RecolorProposals> future = QtConcurrent::mapped(fileNames,
+                                                            FindProposals(sourceColors,
+                                                                          tolerance));
+    d->watcher.setFuture(future);
+    d->searching = true;
+
+    return future;
+}
+
+void ProjectRecolor::cancel()
+{
+    // The scan stops at the next file, the finished() of the watcher ends
+    // the search
+    d->watcher.cancel();
+}
+
+void ProjectRecolor::apply(const QString &replaceText, const QList<SearchResultItem> &items)
+{
+    d->apply(*d->current, replaceText, items);
+}
+
+void ProjectRecolor::setDecimals(ColorFormat format, int decimals)
+{
+    d->decimals[format] = qBound(MIN_COLOR_DECIMALS, decimals, MAX_COLOR_DECIMALS);
+}
+
+} // namespace Internal
+} // namespace ColorPicker
@@ -0,0 +1,64 @@
+#ifndef PROJECTRECOLOR_H
+#define PROJECTRECOLOR_H
+
+#include <QFuture>
+#include <QObject>
+
+#include <coreplugin/find/searchresultitem.h>
+
+#include "colorutilities.h"
+
+namespace ColorPicker {
+namespace Internal {
+
+class ProjectRecolorImpl;
+
+// A color expression of a file that is going to be rewritten
+struct RecolorProposal
+{
+    QString fileName;
+    int line;                   // 1-based
+    int column;                 // 1-based, in characters
+    QString lineText;
+    QString oldText;
+    ColorFormat format;
+};
+
+typedef QVector<RecolorProposal> RecolorProposals;
+
+// Replaces colors across many files. The files are scanned in parallel and
+// the proposals stream into the Search Results pane, where the user reviews
+// them. The accepted ones are applied file by file, through the open
+// documents when there are some, without opening new editors.
+class ProjectRecolor : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit ProjectRecolor(QObject *parent = nullptr);
+    ~ProjectRecolor();
+
+    QFuture<RecolorProposals> start(const QStringList &fileNames,
+                                    const QVector<QColor> &sourceColors,
+                                    const QColor &targetColor, int tolerance);
+    void cancel();
+
+    // Rewrites the accepted proposals of the last search. The replacement
+    // text is read in the category of each file, falling back to the target
+    // color.
+    void apply(const QString &replaceText, const QList<Core::SearchResultItem> &items);
+
+    // Decimals of the float components written in this format
+    void setDecimals(ColorFormat format, int decimals);
+
+signals:
+    void applied(int replacementCount, int fileCount);
+
+private:
+    QScopedPointer<ProjectRecolorImpl> d;
+};
+
+} // namespace Internal
+} // namespace ColorPicker
+
+#endif // PROJECTRECOLOR_H
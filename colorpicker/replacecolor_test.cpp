@@ -3,6 +3,7 @@
 
 // Qt includes
 #include <QAction>
+#include <QTextCursor>
 #include <QtTest>
 
 // QtCreator includes
@@ -12,9 +13,14 @@
 #include <texteditor/texteditor.h>
 
 // Plugin includes
+#include "colorindex.h"
 #include "colormodifier.h"
 #include "colorpickerconstants.h"
 #include "colorwatcher.h"
+#include "projectrecolor.h"
+
+#include "widgets/coloreditor.h"
+#include "widgets/coloreditordialog.h"
 
 using namespace Core;
 using namespace TextEditor;
@@ -46,11 +52,265 @@ void ColorPickerPlugin::test_addAndReplaceColor()
 
     for (auto it = colors.begin(); it != colors.end(); ++it) {
         d->colorModifier->insertColor(it.value(), it.key());
+
+        // Only the differing part is rewritten, the whole expression stays selected
+        QCOMPARE(editorWidget->textCursor().selectedText(),
+                 colorToString(it.value(), it.key()));
+
         colorEditCommand->action()->trigger();
     }
 
     file.close();
 }
 
+void ColorPickerPlugin::test_replaceAllColors()
+{
+    QString fileName = QString::fromLatin1("test_ColorPickerPlugin_replaceAllColors.txt");
+    QFile file(fileName);
+    QVERIFY(file.open(QIODevice::ReadWrite | QIODevice::Text));
+
+    IEditor *currentEditor = EditorManager::instance()->openEditor(fileName);
+    QVERIFY(currentEditor);
+
+    auto editorWidget = qobject_cast<TextEditorWidget *>(currentEditor->widget());
+    QVERIFY(editorWidget);
+
+    editorWidget->setPlainText(QString::fromLatin1("a: rgb(12, 20, 40);\nb: #0C1428;\n"
+                                                   "c: rgb(13, 20, 40);\nd: rgb(100, 0, 0);"));
+
+    // The occurrences are read from the index of the document
+    ColorWatcher *watcher = d->watcherForEditor(currentEditor, editorWidget);
+    QTRY_VERIFY(watcher->colorIndex()->isReady());
+
+    QTextCursor cursor = editorWidget->textCursor();
+    cursor.setPosition(5);
+    editorWidget->setTextCursor(cursor);
+
+    const int tolerance = d->generalSettings.m_replaceTolerance;
+    d->generalSettings.m_replaceTolerance = 1;
+
+    ActionManager::command(Constants::REPLACE_COLOR)->action()->trigger();
+
+    d->generalSettings.m_replaceTolerance = tolerance;
+
+    QVERIFY(d->colorModifier->isPinned());
+
+    // Each occurrence keeps its format, the colors out of the tolerance stay
+    d->colorModifier->insertColor(QColor(32, 18, 26), QCssRgbUCharFormat);
+
+    QCOMPARE(editorWidget->toPlainText(),
+             QString::fromLatin1("a: rgb(32, 18, 26);\nb: #20121A;\n"
+                                 "c: rgb(32, 18, 26);\nd: rgb(100, 0, 0);"));
+
+    // The occurrence under the cursor stays selected
+    QCOMPARE(editorWidget->textCursor().selectedText(), QString::fromLatin1("rgb(32, 18, 26)"));
+
+    d->colorModifier->unpin();
+    d->editorDialog()->hide();
+
+    file.close();
+}
+
+void ColorPickerPlugin::test_previewColor()
+{
+    QString fileName = QString::fromLatin1("test_ColorPickerPlugin_previewColor.txt");
+    QFile file(fileName);
+    QVERIFY(file.open(QIODevice::ReadWrite | QIODevice::Text));
+
+    IEditor *currentEditor = EditorManager::instance()->openEditor(fileName);
+    QVERIFY(currentEditor);
+
+    auto editorWidget = qobject_cast<TextEditorWidget *>(currentEditor->widget());
+    QVERIFY(editorWidget);
+
+    editorWidget->setPlainText(QString::fromLatin1("a: rgb(12, 20, 40);\nb: #000000;"));
+
+    QTextCursor cursor = editorWidget->textCursor();
+    cursor.setPosition(5);
+    editorWidget->setTextCursor(cursor);
+
+    const bool previewChanges = d->generalSettings.m_previewChanges;
+    d->generalSettings.m_previewChanges = true;
+
+    Command *colorEditCommand = ActionManager::command(Constants::TRIGGER_COLOR_EDIT);
+    colorEditCommand->action()->trigger();
+
+    ColorEditor *colorEditor = d->editorDialog()->colorWidget();
+
+    // The edited color is only drawn over the text
+    colorEditor->setColor(QColor(32, 18, 26));
+    onColorChanged(QColor(32, 18, 26));
+
+    QVERIFY(d->colorModifier->hasPreview());
+    QCOMPARE(editorWidget->toPlainText(),
+             QString::fromLatin1("a: rgb(12, 20, 40);\nb: #000000;"));
+
+    // Anchored to the edited expression, wherever the editor cursor goes
+    cursor.setPosition(25);
+    editorWidget->setTextCursor(cursor);
+
+    // Closing the dialog writes the previewed color
+    d->editorDialog()->reject();
+
+    QVERIFY(!d->colorModifier->hasPreview());
+    QCOMPARE(editorWidget->toPlainText(),
+             QString::fromLatin1("a: rgb(32, 18, 26);\nb: #000000;"));
+
+    // Enter writes the color of the editor, in the format of the expression
+    cursor.setPosition(25);
+    editorWidget->setTextCursor(cursor);
+
+    colorEditCommand->action()->trigger();
+
+    colorEditor->setColor(QColor(255, 128, 0));
+    onColorChanged(QColor(255, 128, 0));
+
+    QVERIFY(d->colorModifier->hasPreview());
+    QCOMPARE(editorWidget->toPlainText(),
+             QString::fromLatin1("a: rgb(32, 18, 26);\nb: #000000;"));
+
+    QTest::keyClick(colorEditor, Qt::Key_Return);
+
+    QVERIFY(!d->colorModifier->hasPreview());
+    QCOMPARE(editorWidget->toPlainText(),
+             QString::fromLatin1("a: rgb(32, 18, 26);\nb: #FF8000;"));
+
+    d->generalSettings.m_previewChanges = previewChanges;
+
+    d->colorModifier->unpin();
+    d->editorDialog()->hide();
+
+    file.close();
+}
+
+void ColorPickerPlugin::test_pinnedDocument()
+{
+    QString pinnedFileName = QString::fromLatin1("test_ColorPickerPlugin_pinnedDocument.txt");
+    QFile pinnedFile(pinnedFileName);
+    QVERIFY(pinnedFile.open(QIODevice::ReadWrite | QIODevice::Text));
+
+    QString otherFileName = QString::fromLatin1("test_ColorPickerPlugin_pinnedDocumentOther.txt");
+    QFile otherFile(otherFileName);
+    QVERIFY(otherFile.open(QIODevice::ReadWrite | QIODevice::Text));
+
+    IEditor *pinnedEditor = EditorManager::instance()->openEditor(pinnedFileName);
+    QVERIFY(pinnedEditor);
+
+    auto pinnedWidget = qobject_cast<TextEditorWidget *>(pinnedEditor->widget());
+    QVERIFY(pinnedWidget);
+
+    pinnedWidget->setPlainText(QString::fromLatin1("a: rgb(12, 20, 40);"));
+
+    QTextCursor cursor = pinnedWidget->textCursor();
+    cursor.setPosition(5);
+    pinnedWidget->setTextCursor(cursor);
+
+    // The expression under the cursor is pinned when the edit starts
+    ActionManager::command(Constants::TRIGGER_COLOR_EDIT)->action()->trigger();
+    QVERIFY(d->colorModifier->isPinned());
+
+    IEditor *otherEditor = EditorManager::instance()->openEditor(otherFileName);
+    QVERIFY(otherEditor);
+    QVERIFY(EditorManager::instance()->currentEditor() == otherEditor);
+
+    auto otherWidget = qobject_cast<TextEditorWidget *>(otherEditor->widget());
+    QVERIFY(otherWidget);
+
+    const QString otherText = QString::fromLatin1("b: rgb(12, 20, 40);");
+    otherWidget->setPlainText(otherText);
+
+    cursor = otherWidget->textCursor();
+    cursor.setPosition(5);
+    otherWidget->setTextCursor(cursor);
+
+    // Written to the pinned document, not to the current editor
+    d->colorModifier->insertColor(QColor(32, 18, 26), QCssRgbUCharFormat);
+
+    QCOMPARE(pinnedWidget->toPlainText(), QString::fromLatin1("a: rgb(32, 18, 26);"));
+    QCOMPARE(otherWidget->toPlainText(), otherText);
+
+    d->colorModifier->unpin();
+    d->editorDialog()->hide();
+
+    pinnedFile.close();
+    otherFile.close();
+}
+
+void ColorPickerPlugin::test_recolorFiles()
+{
+    QString fileName = QString::fromLatin1("test_ColorPickerPlugin_recolorFiles.css");
+    QFile file(fileName);
+    QVERIFY(file.open(QIODevice::WriteOnly));
+
+    // Multibyte characters before a color and CRLF line endings
+    file.write("/* \xc3\xa9t\xc3\xa9 */ a { color: #FF0000; }\r\n"
+               "b { background: rgb(255, 0, 0); }\r\n"
+               "c { border-color: #0000FF; }\r\n");
+    file.close();
+
+    QFuture<RecolorProposals> future =
+            d->projectRecolor->start(QStringList() << fileName,
+                                     QVector<QColor>() << QColor(255, 0, 0),
+                                     QColor(0, 0, 255), 0);
+
+    QFutureWatcher<RecolorProposals> watcher;
+    QSignalSpy finishedSpy(&watcher, &QFutureWatcher<RecolorProposals>::finished);
+    watcher.setFuture(future);
+    QVERIFY(finishedSpy.wait());
+
+    RecolorProposals proposals;
+
+    for (const RecolorProposals &results : future.results())
+        proposals += results;
+
+    QCOMPARE(proposals.size(), 2);
+
+    // Lines and columns are counted in characters, not in bytes
+    QCOMPARE(proposals.at(0).line, 1);
+    QCOMPARE(proposals.at(0).column, 22);
+    QCOMPARE(proposals.at(0).lineText,
+             QString::fromUtf8("/* \xc3\xa9t\xc3\xa9 */ a { color: #FF0000; }"));
+    QCOMPARE(proposals.at(0).oldText, QString::fromLatin1("#FF0000"));
+    QCOMPARE(proposals.at(0).format, HexFormat);
+
+    QCOMPARE(proposals.at(1).line, 2);
+    QCOMPARE(proposals.at(1).column, 17);
+    QCOMPARE(proposals.at(1).lineText, QString::fromLatin1("b { background: rgb(255, 0, 0); }"));
+    QCOMPARE(proposals.at(1).oldText, QString::fromLatin1("rgb(255, 0, 0)"));
+    QCOMPARE(proposals.at(1).format, QCssRgbUCharFormat);
+
+    // The edited replacement overrides the target color
+    QList<SearchResultItem> items;
+
+    for (int i = 0; i < proposals.size(); ++i) {
+        SearchResultItem item;
+        item.userData = i;
+        items << item;
+    }
+
+    QSignalSpy appliedSpy(d->projectRecolor, &ProjectRecolor::applied);
+    d->projectRecolor->apply(QString::fromLatin1(" #00FF00 "), items);
+
+    QCOMPARE(appliedSpy.count(), 1);
+    QCOMPARE(appliedSpy.at(0).at(0).toInt(), 2);
+    QCOMPARE(appliedSpy.at(0).at(1).toInt(), 1);
+
+    QVERIFY(file.open(QIODevice::ReadOnly));
+    QCOMPARE(file.readAll(),
+             QByteArray("/* \xc3\xa9t\xc3\xa9 */ a { color: #00FF00; }\r\n"
+                        "b { background: rgb(0, 255, 0); }\r\n"
+                        "c { border-color: #0000FF; }\r\n"));
+    file.close();
+
+    // The proposals no longer match the file, nothing is rewritten
+    d->projectRecolor->apply(QString::fromLatin1("#0000FF"), items);
+
+    QCOMPARE(appliedSpy.count(), 2);
+    QCOMPARE(appliedSpy.at(1).at(0).toInt(), 0);
+    QCOMPARE(appliedSpy.at(1).at(1).toInt(), 0);
+
+    QVERIFY(file.remove());
+}
+
 } // namespace Internal
 } // namespace ColorPicker
@@ -72,7 +72,6 @@ public:
 
     ColorCategory category;
     ColorFormatSet availableFormats;
-    QMap<QAbstractButton *, ColorFormat> buttonToColorFormat;
 
     ColorFormat outputFormat;
     QColor color;
@@ -85,14 +84,8 @@ public:
 
     ColorFrame *colorFrame;
     QHBoxLayout *formatsLayout;
-    QButtonGroup *btnGroup;
-    QToolButton *rgbBtn;
-    QToolButton *hsvBtn;
-    QToolButton *hslBtn;
-    QToolButton *qmlRgbaBtn;
-    QToolButton *qmlHslaBtn;
-    QToolButton *vecBtn;
-    QToolButton *hexBtn;
+    QButtonGroup *btnGroup;             // Button ids are the formats
+    QToolButton *formatButtons[COLOR_FORMAT_COUNT];
 };
 
 Q_DECLARE_OPERATORS_FOR_FLAGS(ColorEditorImpl::UpdateReasons)
@@ -101,7 +94,6 @@ ColorEditorImpl::ColorEditorImpl(ColorEditor *qq) :
     q(qq),
     category(ColorCategory::CssCategory), // trick
     availableFormats(),
-    buttonToColorFormat(),
     outputFormat(),
     color(QColor::Hsv),
     colorPicker(new ColorPickerWidget(qq)),
@@ -112,13 +104,7 @@ ColorEditorImpl::ColorEditorImpl(ColorEditor *qq) :
     colorFrame(new ColorFrame()),
     formatsLayout(new QHBoxLayout),
     btnGroup(new QButtonGroup(qq)),
-    rgbBtn(new QToolButton(qq)),
-    hsvBtn(new QToolButton(qq)),
-    hslBtn(new QToolButton(qq)),
-    qmlRgbaBtn(new QToolButton(qq)),
-    qmlHslaBtn(new QToolButton(qq)),
-    vecBtn(new QToolButton(qq)),
-    hexBtn(new QToolButton(qq))
+    formatButtons()
 {}
 
 void ColorEditorImpl::updateColorWidgets(const QColor &cl, UpdateReasons whichUpdate)
@@ -179,60 +165,19 @@ void ColorEditorImpl::updateFormatsLayout()
     }
 
     // Populate with right buttons
-    if (availableFormats.contains(ColorFormat::QCssRgbUCharFormat)) {
-        rgbBtn->setVisible(true);
-        formatsLayout->addWidget(rgbBtn);
-    }
-    else {
-        rgbBtn->setVisible(false);
-    }
-
-    if (availableFormats.contains(ColorFormat::QssHsvFormat)) {
-        hsvBtn->setVisible(true);
-        formatsLayout->addWidget(hsvBtn);
-    }
-    else {
-        hsvBtn->setVisible(false);
-    }
-
-    if (availableFormats.contains(ColorFormat::CssHslFormat)) {
-        hslBtn->setVisible(true);
-        formatsLayout->addWidget(hslBtn);
-    }
-    else {
-        hslBtn->setVisible(false);
-    }
-
-    if (availableFormats.contains(ColorFormat::QmlRgbaFormat)) {
-        qmlRgbaBtn->setVisible(true);
-        formatsLayout->addWidget(qmlRgbaBtn);
-    }
-    else {
-        qmlRgbaBtn->setVisible(false);
-    }
-
-    if (availableFormats.contains(ColorFormat::QmlHslaFormat)) {
-        qmlHslaBtn->setVisible(true);
-        formatsLayout->addWidget(qmlHslaBtn);
-    }
-    else {
-        qmlHslaBtn->setVisible(false);
-    }
-
-    if (availableFormats.contains(ColorFormat::GlslFormat)) {
-        vecBtn->setVisible(true);
-        formatsLayout->addWidget(vecBtn);
-    }
-    else {
-        vecBtn->setVisible(false);
-    }
-
-    if (availableFormats.contains(ColorFormat::HexFormat)) {
-        hexBtn->setVisible(true);
-        formatsLayout->addWidget(hexBtn);
-    }
-    else {
-        hexBtn->setVisible(false);
+    for (int i = 0; i < COLOR_FORMAT_COUNT; ++i) {
+        QToolButton *button = formatButtons[i];
+
+        if (!button)
+            continue;
+
+        if (availableFormats.contains(ColorFormat(i))) {
+            button->setVisible(true);
+            formatsLayout->addWidget(button);
+        }
+        else {
+            button->setVisible(false);
+        }
     }
 
     formatsLayout->addStretch();
@@ -266,34 +211,7 @@ void ColorEditorImpl::setCurrentColor(const QColor &cl)
 
 QAbstractButton *ColorEditorImpl::colorFormatToButton(ColorFormat format) const
 {
-    QAbstractButton *ret = nullptr;
-
-    switch (format) {
-    case QCssRgbUCharFormat:
-    case QCssRgbPercentFormat:
-        ret = rgbBtn;
-        break;
-    case QssHsvFormat:
-        ret = hsvBtn;
-        break;
-    case CssHslFormat:
-        ret = hslBtn;
-        break;
-    case QmlRgbaFormat:
-        ret = qmlRgbaBtn;
-        break;
-    case QmlHslaFormat:
-        ret = qmlHslaBtn;
-        break;
-    case GlslFormat:
-        ret = vecBtn;
-        break;
-    case HexFormat:
-        ret = hexBtn;
-        break;
-    default:
-        break;
-    }
+    QAbstractButton *ret = formatButtons[colorFormatButtonOwner(format)];
 
     Q_ASSERT(ret);
     return ret;
@@ -364,21 +282,20 @@ ColorEditor::ColorEditor(QWidget *parent) :
 
     // Build UI
     // Color format selection
-    d->rgbBtn->setText(QLatin1String("rgb"));
-    d->hsvBtn->setText(QLatin1String("hsv"));
-    d->hslBtn->setText(QLatin1String("hsl"));
-    d->qmlRgbaBtn->setText(QLatin1String("Qt.rgba"));
-    d->qmlHslaBtn->setText(QLatin1String("Qt.hsla"));
-    d->vecBtn->setText(QLatin1String("vec"));
-    d->hexBtn->setText(QLatin1String("hex"));
-
-    d->rgbBtn->setCheckable(true);
-    d->hsvBtn->setCheckable(true);
-    d->hslBtn->setCheckable(true);
-    d->qmlRgbaBtn->setCheckable(true);
-    d->qmlHslaBtn->setCheckable(true);
-    d->vecBtn->setCheckable(true);
-    d->hexBtn->setCheckable(true);
+    for (int i = 0; i < COLOR_FORMAT_COUNT; ++i) {
+        const auto format = ColorFormat(i);
+        const char *label = colorFormatButtonLabel(format);
+
+        if (!label)
+            continue;
+
+        auto button = new QToolButton(this);
+        button->setText(QLatin1String(label));
+        button->setCheckable(true);
+
+        d->formatButtons[i] = button;
+        d->btnGroup->addButton(button, format);
+    }
 
     // Build layouts
     d->formatsLayout->setSpacing(0);
@@ -410,25 +327,9 @@ ColorEditor::ColorEditor(QWidget *parent) :
     mainLayout->addLayout(centerLayout);
 
     // Color format selection logic
-    d->btnGroup->addButton(d->rgbBtn);
-    d->btnGroup->addButton(d->hsvBtn);
-    d->btnGroup->addButton(d->hslBtn);
-    d->btnGroup->addButton(d->qmlRgbaBtn);
-    d->btnGroup->addButton(d->qmlHslaBtn);
-    d->btnGroup->addButton(d->vecBtn);
-    d->btnGroup->addButton(d->hexBtn);
-
-    d->buttonToColorFormat.insert(d->rgbBtn, ColorFormat::QCssRgbUCharFormat);
-    d->buttonToColorFormat.insert(d->hsvBtn, ColorFormat::QssHsvFormat);
-    d->buttonToColorFormat.insert(d->hslBtn, ColorFormat::CssHslFormat);
-    d->buttonToColorFormat.insert(d->qmlRgbaBtn, ColorFormat::QmlRgbaFormat);
-    d->buttonToColorFormat.insert(d->qmlHslaBtn, ColorFormat::QmlHslaFormat);
-    d->buttonToColorFormat.insert(d->vecBtn, ColorFormat::GlslFormat);
-    d->buttonToColorFormat.insert(d->hexBtn, ColorFormat::HexFormat);
-
     connect(d->btnGroup, qOverload<QAbstractButton *>(&QButtonGroup::buttonClicked),
             [=] (QAbstractButton *btn) {
-        ColorFormat format = d->buttonToColorFormat.value(btn);
+        auto format = ColorFormat(d->btnGroup->id(btn));
 
         d->setCurrentFormat(format);
     });
@@ -449,6 +350,19 @@ ColorEditor::ColorEditor(QWidget *parent) :
     connect(d->opacitySlider, &OpacitySlider::valueChanged,
             [=](int opacity) { d->onOpacityChanged(opacity); });
 
+    // Drag sessions
+    connect(d->colorPicker, &ColorPickerWidget::pressed, this, &ColorEditor::editStarted);
+    connect(d->colorPicker, &ColorPickerWidget::released, this, &ColorEditor::editFinished);
+
+    const QList<AdvancedSlider *> sliders = {
+        d->hueSlider, d->saturationSlider, d->valueSlider, d->opacitySlider
+    };
+
+    for (AdvancedSlider *slider : sliders) {
+        connect(slider, &AdvancedSlider::sliderPressed, this, &ColorEditor::editStarted);
+        connect(slider, &AdvancedSlider::sliderReleased, this, &ColorEditor::editFinished);
+    }
+
     setColorCategory(ColorCategory::AnyCategory);
     setOutputFormat(ColorFormat::QCssRgbUCharFormat);
     setColor(Qt::red);
@@ -48,6 +48,11 @@ signals:
     void hueChanged(int);
     void opacityChanged(int);
 
+    // The user drags the color picker or a slider, colorChanged() being
+    // emitted many times in between
+    void editStarted();
+    void editFinished();
+
 protected:
     void keyPressEvent(QKeyEvent *e) override;
 
@@ -4,6 +4,8 @@
 #include <QMouseEvent>
 #include <QPainter>
 
+#include "../colortrace.h"
+
 namespace ColorPicker {
 namespace Internal {
 
@@ -179,6 +181,9 @@ void ColorPickerWidget::paintEvent(QPaintEvent *)
         painter.setPen(pen);
         painter.drawEllipse(d->cursorPos, 7, 7);
     }
+
+    // The color editor is visible
+    traceEnd(TRACE_TRIGGER_TO_PAINT);
 }
 
 void ColorPickerWidget::resizeEvent(QResizeEvent *)
@@ -188,6 +193,8 @@ void ColorPickerWidget::resizeEvent(QResizeEvent *)
 
 void ColorPickerWidget::mousePressEvent(QMouseEvent *e)
 {
+    emit pressed();
+
     d->processMouseEvent(e);
 }
 
@@ -196,6 +203,13 @@ void ColorPickerWidget::mouseMoveEvent(QMouseEvent *e)
     d->processMouseEvent(e);
 }
 
+void ColorPickerWidget::mouseReleaseEvent(QMouseEvent *e)
+{
+    e->accept();
+
+    emit released();
+}
+
 void ColorPickerWidget::keyPressEvent(QKeyEvent *e)
 {
     int h, s ,v;
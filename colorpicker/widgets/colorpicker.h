@@ -25,6 +25,10 @@ public:
 signals:
     void colorChanged(QColor);
 
+    // A drag of the cursor starts and ends
+    void pressed();
+    void released();
+
 public slots:
     void setColor(const QColor &color);
 
@@ -34,6 +38,7 @@ protected:
 
     void mousePressEvent(QMouseEvent *e) override;
     void mouseMoveEvent(QMouseEvent *e) override;
+    void mouseReleaseEvent(QMouseEvent *e) override;
 
     void keyPressEvent(QKeyEvent *e) override;
 
@@ -3,8 +3,11 @@
 // Qt includes
 #include <QBoxLayout>
 #include <QCheckBox>
+#include <QLabel>
+#include <QSpinBox>
 
 // Plugin includes
+#include "../colorutilities.h"
 #include "../generalsettings.h"
 
 namespace ColorPicker {
@@ -13,14 +16,66 @@ namespace Internal {
 ColorPickerSettingsWidget::ColorPickerSettingsWidget(QWidget *parent) :
     QWidget(parent),
     m_editorSensitiveCheckBox(new QCheckBox(this)),
-    m_insertOnChangeCheckBox(new QCheckBox(this))
+    m_insertOnChangeCheckBox(new QCheckBox(this)),
+    m_previewChangesCheckBox(new QCheckBox(this)),
+    m_showSwatchesCheckBox(new QCheckBox(this)),
+    m_showTooltipsCheckBox(new QCheckBox(this)),
+    m_replaceToleranceSpinBox(new QSpinBox(this)),
+    m_qmlDecimalsSpinBox(new QSpinBox(this)),
+    m_glslDecimalsSpinBox(new QSpinBox(this))
 {
     m_editorSensitiveCheckBox->setText(QLatin1String("Show the available formats according to the current editor."));
     m_insertOnChangeCheckBox->setText(QLatin1String("Insert text when the displayed color changes."));
+    m_previewChangesCheckBox->setText(QLatin1String("Only preview the text over the editor, insert it on Enter or when the dialog is closed."));
+    m_showSwatchesCheckBox->setText(QLatin1String("Show a swatch next to the colors of the text editors."));
+    m_showTooltipsCheckBox->setText(QLatin1String("Show a tooltip when hovering a color."));
+
+    // Previewing is a way of inserting on change
+    connect(m_insertOnChangeCheckBox, &QCheckBox::toggled,
+            m_previewChangesCheckBox, &QCheckBox::setEnabled);
+
+    auto previewChangesLayout = new QHBoxLayout;
+    previewChangesLayout->addSpacing(20);
+    previewChangesLayout->addWidget(m_previewChangesCheckBox);
+
+    m_replaceToleranceSpinBox->setRange(0, 255);
+
+    auto replaceToleranceLabel = new QLabel(this);
+    replaceToleranceLabel->setText(QLatin1String("Channel tolerance when replacing all the occurrences of a color:"));
+
+    auto replaceToleranceLayout = new QHBoxLayout;
+    replaceToleranceLayout->addWidget(replaceToleranceLabel);
+    replaceToleranceLayout->addWidget(m_replaceToleranceSpinBox);
+    replaceToleranceLayout->addStretch();
+
+    m_qmlDecimalsSpinBox->setRange(MIN_COLOR_DECIMALS, MAX_COLOR_DECIMALS);
+    m_glslDecimalsSpinBox->setRange(MIN_COLOR_DECIMALS, MAX_COLOR_DECIMALS);
+
+    auto qmlDecimalsLabel = new QLabel(this);
+    qmlDecimalsLabel->setText(QLatin1String("Decimals of the Qt.rgba() and Qt.hsla() components:"));
+
+    auto qmlDecimalsLayout = new QHBoxLayout;
+    qmlDecimalsLayout->addWidget(qmlDecimalsLabel);
+    qmlDecimalsLayout->addWidget(m_qmlDecimalsSpinBox);
+    qmlDecimalsLayout->addStretch();
+
+    auto glslDecimalsLabel = new QLabel(this);
+    glslDecimalsLabel->setText(QLatin1String("Decimals of the vec3() and vec4() components:"));
+
+    auto glslDecimalsLayout = new QHBoxLayout;
+    glslDecimalsLayout->addWidget(glslDecimalsLabel);
+    glslDecimalsLayout->addWidget(m_glslDecimalsSpinBox);
+    glslDecimalsLayout->addStretch();
 
     auto mainLayout = new QVBoxLayout(this);
     mainLayout->addWidget(m_editorSensitiveCheckBox);
     mainLayout->addWidget(m_insertOnChangeCheckBox);
+    mainLayout->addLayout(previewChangesLayout);
+    mainLayout->addWidget(m_showSwatchesCheckBox);
+    mainLayout->addWidget(m_showTooltipsCheckBox);
+    mainLayout->addLayout(replaceToleranceLayout);
+    mainLayout->addLayout(qmlDecimalsLayout);
+    mainLayout->addLayout(glslDecimalsLayout);
     mainLayout->addStretch();
 }
 
@@ -33,12 +88,25 @@ void ColorPickerSettingsWidget::settingsFromUI(GeneralSettings *settings)
 
     settings->m_editorSensitive = m_editorSensitiveCheckBox->isChecked();
     settings->m_insertOnChange = m_insertOnChangeCheckBox->isChecked();
+    settings->m_previewChanges = m_previewChangesCheckBox->isChecked();
+    settings->m_replaceTolerance = m_replaceToleranceSpinBox->value();
+    settings->m_showSwatches = m_showSwatchesCheckBox->isChecked();
+    settings->m_showTooltips = m_showTooltipsCheckBox->isChecked();
+    settings->m_qmlDecimals = m_qmlDecimalsSpinBox->value();
+    settings->m_glslDecimals = m_glslDecimalsSpinBox->value();
 }
 
 void ColorPickerSettingsWidget::settingsToUI(const GeneralSettings settings)
 {
     m_editorSensitiveCheckBox->setChecked(settings.m_editorSensitive);
     m_insertOnChangeCheckBox->setChecked(settings.m_insertOnChange);
+    m_previewChangesCheckBox->setChecked(settings.m_previewChanges);
+    m_previewChangesCheckBox->setEnabled(settings.m_insertOnChange);
+    m_replaceToleranceSpinBox->setValue(settings.m_replaceTolerance);
+    m_showSwatchesCheckBox->setChecked(settings.m_showSwatches);
+    m_showTooltipsCheckBox->setChecked(settings.m_showTooltips);
+    m_qmlDecimalsSpinBox->setValue(settings.m_qmlDecimals);
+    m_glslDecimalsSpinBox->setValue(settings.m_glslDecimals);
 }
 
 } // namespace Internal
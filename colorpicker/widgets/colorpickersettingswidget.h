@@ -4,6 +4,7 @@
 #include <QWidget>
 
 class QCheckBox;
+class QSpinBox;
 
 namespace ColorPicker {
 namespace Internal {
@@ -24,6 +25,12 @@ public:
 private:
     QCheckBox *m_editorSensitiveCheckBox;
     QCheckBox *m_insertOnChangeCheckBox;
+    QCheckBox *m_previewChangesCheckBox;
+    QCheckBox *m_showSwatchesCheckBox;
+    QCheckBox *m_showTooltipsCheckBox;
+    QSpinBox *m_replaceToleranceSpinBox;
+    QSpinBox *m_qmlDecimalsSpinBox;
+    QSpinBox *m_glslDecimalsSpinBox;
 };
 
 } // namespace Internal
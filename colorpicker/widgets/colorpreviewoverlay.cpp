@@ -0,0 +1,141 @@
+#include "colorpreviewoverlay.h"
+
+// Qt includes
+#include <QPainter>
+#include <QTextBlock>
+#include <QTextCursor>
+
+// QtCreator includes
+#include <texteditor/texteditor.h>
+
+using namespace TextEditor;
+
+namespace {
+
+const int PREVIEW_MARGIN = 1;
+
+} // anon namespace
+
+namespace ColorPicker {
+namespace Internal {
+
+
+////////////////////////// ColorPreviewOverlayImpl //////////////////////////
+
+class ColorPreviewOverlayImpl
+{
+public:
+    ColorPreviewOverlayImpl(TextEditorWidget *editor);
+
+    /* variables */
+    TextEditorWidget *editor;
+
+    QVector<QTextCursor> ranges;    // Follow the edits of the document
+    QStringList texts;
+};
+
+ColorPreviewOverlayImpl::ColorPreviewOverlayImpl(TextEditorWidget *editor) :
+    editor(editor),
+    ranges(),
+    texts()
+{}
+
+
+////////////////////////// ColorPreviewOverlay //////////////////////////
+
+ColorPreviewOverlay::ColorPreviewOverlay(TextEditorWidget *editor) :
+    QWidget(editor->viewport()),
+    d(new ColorPreviewOverlayImpl(editor))
+{
+    setAttribute(Qt::WA_TransparentForMouseEvents);
+    setAttribute(Qt::WA_NoSystemBackground);
+
+    resize(editor->viewport()->size());
+
+    connect(editor, &TextEditorWidget::updateRequest,
+            this, [=](const QRect &rect, int dy) {
+        if (dy)
+            update();
+        else
+            update(rect);
+    });
+
+    editor->viewport()->installEventFilter(this);
+}
+
+ColorPreviewOverlay::~ColorPreviewOverlay()
+{}
+
+TextEditorWidget *ColorPreviewOverlay::editor() const
+{
+    return d->editor;
+}
+
+void ColorPreviewOverlay::setPreview(const QVector<QTextCursor> &ranges,
+                                     const QStringList &texts)
+{
+    Q_ASSERT(ranges.size() == texts.size());
+
+    d->ranges = ranges;
+    d->texts = texts;
+
+    update();
+}
+
+bool ColorPreviewOverlay::eventFilter(QObject *watched, QEvent *event)
+{
+    if (watched == d->editor->viewport() && event->type() == QEvent::Resize)
+        resize(d->editor->viewport()->size());
+
+    return false;
+}
+
+void ColorPreviewOverlay::paintEvent(QPaintEvent *e)
+{
+    Q_UNUSED(e);
+
+    QPainter painter(this);
+    painter.setFont(d->editor->font());
+
+    const QFontMetrics metrics(d->editor->font());
+    const QPalette editorPalette = d->editor->palette();
+
+    for (int i = 0; i < d->ranges.size(); ++i) {
+        const QTextCursor &range = d->ranges.at(i);
+
+        QTextCursor startCursor(range);
+        startCursor.setPosition(range.selectionStart());
+
+        QTextCursor endCursor(range);
+        endCursor.setPosition(range.selectionEnd());
+
+        // Expressions never span several lines
+        if (startCursor.block() != endCursor.block() || !startCursor.block().isVisible())
+            continue;
+
+        const QRect startRect = d->editor->cursorRect(startCursor);
+
+        if (startRect.bottom() < 0 || startRect.top() > height())
+            continue;
+
+        const QString &text = d->texts.at(i);
+        const int replacedWidth = d->editor->cursorRect(endCursor).left() - startRect.left();
+
+        QRect textRect(startRect.left(), startRect.top(),
+                       qMax(replacedWidth, metrics.width(text)), startRect.height());
+
+        // Hides the current text, the preview may be shorter
+        painter.fillRect(textRect.adjusted(0, 0, PREVIEW_MARGIN, 0),
+                         editorPalette.color(QPalette::Base));
+
+        painter.setPen(editorPalette.color(QPalette::Text));
+        painter.drawText(textRect, Qt::AlignLeft | Qt::AlignVCenter, text);
+
+        // Not written yet
+        painter.setPen(QPen(editorPalette.color(QPalette::Highlight), 1, Qt::DashLine));
+        painter.drawRect(textRect.adjusted(0, 0, PREVIEW_MARGIN - 1, -1));
+    }
+}
+
+} // namespace Internal
+} // namespace ColorPicker
@@ -0,0 +1,43 @@
+#ifndef COLORPREVIEWOVERLAY_H
+#define COLORPREVIEWOVERLAY_H
+
+#include <QWidget>
+
+class QTextCursor;
+
+namespace TextEditor {
+class TextEditorWidget;
+}
+
+namespace ColorPicker {
+namespace Internal {
+
+class ColorPreviewOverlayImpl;
+
+// Draws the next text of the edited expressions over their current text,
+// the document being left untouched until the edit is committed
+class ColorPreviewOverlay : public QWidget
+{
+    Q_OBJECT
+
+public:
+    explicit ColorPreviewOverlay(TextEditor::TextEditorWidget *editor);
+    ~ColorPreviewOverlay();
+
+    TextEditor::TextEditorWidget *editor() const;
+
+    // Each cursor selects the text replaced by the string of the same index
+    void setPreview(const QVector<QTextCursor> &ranges, const QStringList &texts);
+
+protected:
+    bool eventFilter(QObject *watched, QEvent *event) override;
+    void paintEvent(QPaintEvent *e) override;
+
+private:
+    QScopedPointer<ColorPreviewOverlayImpl> d;
+};
+
+} // namespace Internal
+} // namespace ColorPicker
+
+#endif // COLORPREVIEWOVERLAY_H
@@ -0,0 +1,178 @@
+#include "colorswatchoverlay.h"
+
+// Qt includes
+#include <QMouseEvent>
+#include <QPainter>
+#include <QTextBlock>
+
+// QtCreator includes
+#include <texteditor/texteditor.h>
+
+// Plugin includes
+#include "../colorwatcher.h"
+#include "drawhelpers.h"
+
+using namespace TextEditor;
+
+namespace {
+
+const int SWATCH_MARGIN = 4;
+
+} // anon namespace
+
+namespace ColorPicker {
+namespace Internal {
+
+
+////////////////////////// ColorSwatchOverlayImpl //////////////////////////
+
+class ColorSwatchOverlayImpl
+{
+public:
+    ColorSwatchOverlayImpl(TextEditorWidget *editor, ColorWatcher *watcher);
+
+    /* variables */
+    struct Swatch
+    {
+        QRect rect;
+        int position;           // Of the expression in the document
+        int length;
+    };
+
+    TextEditorWidget *editor;
+    ColorWatcher *watcher;
+
+    QVector<Swatch> swatches;   // As painted the last time
+    QBrush checkerboard;
+};
+
+ColorSwatchOverlayImpl::ColorSwatchOverlayImpl(TextEditorWidget *editor, ColorWatcher *watcher) :
+    editor(editor),
+    watcher(watcher),
+    swatches(),
+    checkerboard()
+{}
+
+
+////////////////////////// ColorSwatchOverlay //////////////////////////
+
+ColorSwatchOverlay::ColorSwatchOverlay(TextEditorWidget *editor, ColorWatcher *watcher) :
+    QWidget(editor->viewport()),
+    d(new ColorSwatchOverlayImpl(editor, watcher))
+{
+    setAttribute(Qt::WA_TransparentForMouseEvents);
+    setAttribute(Qt::WA_NoSystemBackground);
+
+    resize(editor->viewport()->size());
+
+    // Scrolling and editing both go through updateRequest()
+    connect(editor, &TextEditorWidget::updateRequest,
+            this, [=](const QRect &rect, int dy) {
+        if (dy)
+            update();
+        else
+            update(rect);
+    });
+
+    editor->viewport()->installEventFilter(this);
+}
+
+ColorSwatchOverlay::~ColorSwatchOverlay()
+{}
+
+QVector<QRect> ColorSwatchOverlay::swatchRects() const
+{
+    QVector<QRect> ret;
+    ret.reserve(d->swatches.size());
+
+    for (const ColorSwatchOverlayImpl::Swatch &swatch : d->swatches)
+        ret.append(swatch.rect);
+
+    return ret;
+}
+
+bool ColorSwatchOverlay::eventFilter(QObject *watched, QEvent *event)
+{
+    if (watched != d->editor->viewport())
+        return false;
+
+    if (event->type() == QEvent::Resize) {
+        resize(d->editor->viewport()->size());
+    }
+    else if (event->type() == QEvent::MouseButtonPress && !isHidden()) {
+        // Only turned off by setSwatchesVisible(), the editor may be hidden
+        // and still receive the events
+        auto mouseEvent = static_cast<QMouseEvent *>(event);
+
+        if (mouseEvent->button() != Qt::LeftButton)
+            return false;
+
+        for (const ColorSwatchOverlayImpl::Swatch &swatch : d->swatches) {
+            if (swatch.rect.contains(mouseEvent->pos())) {
+                emit swatchClicked(swatch.position, swatch.length);
+                return true;
+            }
+        }
+    }
+
+    return false;
+}
+
+void ColorSwatchOverlay::paintEvent(QPaintEvent *e)
+{
+    Q_UNUSED(e);
+
+    d->swatches.clear();
+
+    QPainter painter(this);
+    painter.setPen(QPen(palette().color(QPalette::Text), 0.5));
+
+    const int swatchSide = qMax(4, d->editor->fontMetrics().height() - SWATCH_MARGIN);
+
+    if (d->checkerboard.style() == Qt::NoBrush)
+        d->checkerboard = opacityCheckerboard(QRect(0, 0, swatchSide, swatchSide), 3);
+
+    QTextBlock block = d->editor->cursorForPosition(QPoint(0, 0)).block();
+
+    for (; block.isValid(); block = block.next()) {
+        if (!block.isVisible())
+            continue;
+
+        QTextCursor endCursor(block);
+        endCursor.movePosition(QTextCursor::EndOfBlock);
+
+        const QRect endRect = d->editor->cursorRect(endCursor);
+
+        if (endRect.top() > height())
+            break;
+
+        const BlockColors colors = d->watcher->colorsInBlock(block);
+
+        int x = endRect.right() + 2 * SWATCH_MARGIN;
+        const int y = endRect.center().y() - swatchSide / 2;
+
+        for (int i = 0; i < colors.matches.size(); ++i) {
+            const ColorMatch &match = colors.matches.at(i);
+            const QRect swatchRect(x, y, swatchSide, swatchSide);
+
+            painter.setBrushOrigin(swatchRect.topLeft());
+            painter.setBrush(d->checkerboard);
+            painter.drawRect(swatchRect);
+
+            painter.setBrush(colors.values.at(i));
+            painter.drawRect(swatchRect);
+
+            ColorSwatchOverlayImpl::Swatch swatch;
+            swatch.rect = swatchRect;
+            swatch.position = block.position() + match.start;
+            swatch.length = match.length;
+
+            d->swatches.append(swatch);
+
+            x += swatchSide + SWATCH_MARGIN;
+        }
+    }
+}
+
+} // namespace Internal
+} // namespace ColorPicker
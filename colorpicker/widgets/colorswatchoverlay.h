@@ -0,0 +1,44 @@
+#ifndef COLORSWATCHOVERLAY_H
+#define COLORSWATCHOVERLAY_H
+
+#include <QWidget>
+
+namespace TextEditor {
+class TextEditorWidget;
+}
+
+namespace ColorPicker {
+namespace Internal {
+
+class ColorSwatchOverlayImpl;
+class ColorWatcher;
+
+// Draws a swatch after the text of each line, one per color of the line.
+// Only the visible blocks are looked at, through the block cache of the
+// watcher, so scrolling only scans the lines that become visible.
+class ColorSwatchOverlay : public QWidget
+{
+    Q_OBJECT
+
+public:
+    ColorSwatchOverlay(TextEditor::TextEditorWidget *editor, ColorWatcher *watcher);
+    ~ColorSwatchOverlay();
+
+    // Where the swatches were painted the last time, in viewport coordinates
+    QVector<QRect> swatchRects() const;
+
+signals:
+    void swatchClicked(int position, int length);
+
+protected:
+    bool eventFilter(QObject *watched, QEvent *event) override;
+    void paintEvent(QPaintEvent *e) override;
+
+private:
+    QScopedPointer<ColorSwatchOverlayImpl> d;
+};
+
+} // namespace Internal
+} // namespace ColorPicker
+
+#endif // COLORSWATCHOVERLAY_H
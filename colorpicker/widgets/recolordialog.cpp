@@ -0,0 +1,99 @@
+#include "recolordialog.h"
+
+// Qt includes
+#include <QDialogButtonBox>
+#include <QFormLayout>
+#include <QLineEdit>
+#include <QPushButton>
+#include <QStringList>
+
+// Plugin includes
+#include "../colorscanner.h"
+
+namespace {
+
+using namespace ColorPicker::Internal;
+
+QVector<QColor> colorsFromText(const QString &text)
+{
+    QVector<QColor> ret;
+
+    const ColorScanner scanner;
+
+    for (const ColorMatch &match : scanner.scan(text))
+        ret.append(parseColor(text, match));
+
+    return ret;
+}
+
+} // anon namespace
+
+namespace ColorPicker {
+namespace Internal {
+
+
+////////////////////////// RecolorDialog //////////////////////////
+
+RecolorDialog::RecolorDialog(QWidget *parent) :
+    QDialog(parent),
+    m_sourceEdit(new QLineEdit(this)),
+    m_targetEdit(new QLineEdit(this)),
+    m_okButton(nullptr)
+{
+    setWindowTitle(tr("Recolor Project"));
+    setWindowFlags(windowFlags() & ~Qt::WindowContextHelpButtonHint);
+
+    m_sourceEdit->setPlaceholderText(QLatin1String("#ff0000, rgb(0, 0, 255)"));
+    m_targetEdit->setPlaceholderText(QLatin1String("#00ff00"));
+
+    auto buttonBox = new QDialogButtonBox(QDialogButtonBox::Ok | QDialogButtonBox::Cancel, this);
+    m_okButton = buttonBox->button(QDialogButtonBox::Ok);
+
+    auto layout = new QFormLayout(this);
+    layout->addRow(tr("Replace the colors:"), m_sourceEdit);
+    layout->addRow(tr("With:"), m_targetEdit);
+    layout->addRow(buttonBox);
+
+    connect(buttonBox, &QDialogButtonBox::accepted, this, &QDialog::accept);
+    connect(buttonBox, &QDialogButtonBox::rejected, this, &QDialog::reject);
+
+    connect(m_sourceEdit, &QLineEdit::textChanged, this, &RecolorDialog::updateOkButton);
+    connect(m_targetEdit, &QLineEdit::textChanged, this, &RecolorDialog::updateOkButton);
+
+    updateOkButton();
+}
+
+QVector<QColor> RecolorDialog::sourceColors() const
+{
+    return colorsFromText(m_sourceEdit->text());
+}
+
+void RecolorDialog::setSourceColors(const QVector<QColor> &colors)
+{
+    QStringList texts;
+
+    for (const QColor &color : colors)
+        texts << colorToString(color, HexFormat);
+
+    m_sourceEdit->setText(texts.join(QLatin1String(", ")));
+}
+
+QColor RecolorDialog::targetColor() const
+{
+    const QVector<QColor> colors = colorsFromText(m_targetEdit->text());
+
+    return (colors.isEmpty()) ? QColor() : colors.first();
+}
+
+void RecolorDialog::setTargetColor(const QColor &color)
+{
+    m_targetEdit->setText(colorToString(color, HexFormat));
+}
+
+void RecolorDialog::updateOkButton()
+{
+    m_okButton->setEnabled(!sourceColors().isEmpty() && targetColor().isValid());
+}
+
+} // namespace Internal
+} // namespace ColorPicker
@@ -0,0 +1,40 @@
+#ifndef RECOLORDIALOG_H
+#define RECOLORDIALOG_H
+
+#include <QColor>
+#include <QDialog>
+#include <QVector>
+
+class QLineEdit;
+class QPushButton;
+
+namespace ColorPicker {
+namespace Internal {
+
+// Asks for the colors to replace across the project and their replacement,
+// both written as color expressions of any format
+class RecolorDialog : public QDialog
+{
+    Q_OBJECT
+
+public:
+    explicit RecolorDialog(QWidget *parent = nullptr);
+
+    QVector<QColor> sourceColors() const;
+    void setSourceColors(const QVector<QColor> &colors);
+
+    QColor targetColor() const;
+    void setTargetColor(const QColor &color);
+
+private:
+    void updateOkButton();
+
+    QLineEdit *m_sourceEdit;
+    QLineEdit *m_targetEdit;
+    QPushButton *m_okButton;
+};
+
+} // namespace Internal
+} // namespace ColorPicker
+
+#endif // RECOLORDIALOG_H
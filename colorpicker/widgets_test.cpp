@@ -1,18 +1,216 @@
 // Qt includes
+#include <QAbstractTextDocumentLayout>
+#include <QSignalSpy>
+#include <QTextBlock>
+#include <QTextLayout>
+#include <QToolTip>
 #include <QtTest>
 
+// QtCreator includes
+#include <coreplugin/editormanager/editormanager.h>
+
+#include <texteditor/texteditor.h>
+
 // Plugin includes
+#include "colormodifier.h"
 #include "colorpickerplugin.h"
+#include "colorpickerplugin_p.h"
+#include "colortooltip.h"
+#include "colorwatcher.h"
 
 #include "widgets/coloreditor.h"
+#include "widgets/coloreditordialog.h"
 #include "widgets/colorpicker.h"
+#include "widgets/colorswatchoverlay.h"
 #include "widgets/hueslider.h"
 #include "widgets/opacityslider.h"
 
 using namespace Core;
+using namespace TextEditor;
+
+namespace {
+
+// Where the mouse rests over the given position of the document
+QPoint hoverPoint(TextEditorWidget *editorWidget, int position)
+{
+    QTextCursor cursor(editorWidget->document());
+    cursor.setPosition(position);
+
+    return editorWidget->cursorRect(cursor).center();
+}
+
+void hover(TextEditorWidget *editorWidget, const QPoint &pos)
+{
+    QHoverEvent event(QEvent::HoverMove, pos, pos);
+    QCoreApplication::sendEvent(editorWidget->viewport(), &event);
+}
+
+} // anon namespace
 
 namespace ColorPicker {
 namespace Internal {
 
+void ColorPickerPlugin::test_swatchClick()
+{
+    QString clickedFileName = QString::fromLatin1("test_ColorPickerPlugin_swatchClick.txt");
+    QFile clickedFile(clickedFileName);
+    QVERIFY(clickedFile.open(QIODevice::ReadWrite | QIODevice::Text));
+
+    QString otherFileName = QString::fromLatin1("test_ColorPickerPlugin_swatchClickOther.txt");
+    QFile otherFile(otherFileName);
+    QVERIFY(otherFile.open(QIODevice::ReadWrite | QIODevice::Text));
+
+    IEditor *clickedEditor = EditorManager::instance()->openEditor(clickedFileName);
+    QVERIFY(clickedEditor);
+
+    auto clickedWidget = qobject_cast<TextEditorWidget *>(clickedEditor->widget());
+    QVERIFY(clickedWidget);
+
+    clickedWidget->setPlainText(QString::fromLatin1("a: #ff0000;\nb: rgb(0, 0, 255);"));
+
+    ColorWatcher *watcher = d->watcherForEditor(clickedEditor, clickedWidget);
+    watcher->setSwatchesVisible(true);
+
+    auto overlay = clickedWidget->viewport()->findChild<ColorSwatchOverlay *>();
+    QVERIFY(overlay);
+
+    // One swatch per color of the visible lines, in the order of the text
+    overlay->update();
+    QTRY_COMPARE(overlay->swatchRects().size(), 2);
+
+    const QRect swatchRect = overlay->swatchRects().first();
+
+    // The other editor is the current one when the swatch is clicked
+    IEditor *otherEditor = EditorManager::instance()->openEditor(otherFileName);
+    QVERIFY(otherEditor);
+    QVERIFY(EditorManager::instance()->currentEditor() == otherEditor);
+
+    auto otherWidget = qobject_cast<TextEditorWidget *>(otherEditor->widget());
+    QVERIFY(otherWidget);
+
+    const QString otherText = QString::fromLatin1("c: #ff0000;");
+    otherWidget->setPlainText(otherText);
+
+    QSignalSpy spy(overlay, &ColorSwatchOverlay::swatchClicked);
+
+    // Next to the swatch, the click goes to the editor
+    QTest::mouseClick(clickedWidget->viewport(), Qt::LeftButton, Qt::NoModifier,
+                      swatchRect.topLeft() - QPoint(2, 0));
+    QCOMPARE(spy.count(), 0);
+
+    QTest::mouseClick(clickedWidget->viewport(), Qt::LeftButton, Qt::NoModifier,
+                      swatchRect.center());
+    QCOMPARE(spy.count(), 1);
+    QCOMPARE(spy.first().at(0).toInt(), 3);
+    QCOMPARE(spy.first().at(1).toInt(), 7);
+
+    // The clicked expression is the one edited
+    QCOMPARE(clickedWidget->textCursor().selectedText(), QString::fromLatin1("#ff0000"));
+    QVERIFY(d->colorModifier->isPinned());
+
+    d->colorModifier->insertColor(QColor(0, 255, 0), HexFormat);
+
+    QCOMPARE(clickedWidget->toPlainText(),
+             QString::fromLatin1("a: #00FF00;\nb: rgb(0, 0, 255);"));
+    QCOMPARE(otherWidget->toPlainText(), otherText);
+
+    d->colorModifier->unpin();
+    d->editorDialog()->hide();
+
+    clickedFile.close();
+    otherFile.close();
+}
+
+void ColorPickerPlugin::test_hoverTooltip()
+{
+    QString fileName = QString::fromLatin1("test_ColorPickerPlugin_hoverTooltip.txt");
+    QFile file(fileName);
+    QVERIFY(file.open(QIODevice::ReadWrite | QIODevice::Text));
+
+    IEditor *editor = EditorManager::instance()->openEditor(fileName);
+    QVERIFY(editor);
+
+    auto editorWidget = qobject_cast<TextEditorWidget *>(editor->widget());
+    QVERIFY(editorWidget);
+
+    editorWidget->setPlainText(QString::fromLatin1("a: rgb(255, 0, 0);"));
+
+    ColorWatcher *watcher = d->watcherForEditor(editor, editorWidget);
+    watcher->setTooltipsEnabled(true);
+
+    auto tooltip = watcher->findChild<ColorTooltip *>();
+    QVERIFY(tooltip);
+
+    QToolTip::hideText();
+    QTRY_VERIFY(!QToolTip::isVisible());
+
+    const int builtCount = tooltip->builtCount();
+
+    // Only shown once the mouse rests
+    hover(editorWidget, hoverPoint(editorWidget, 6));
+    QTest::qWait(100);
+    QVERIFY(!QToolTip::isVisible());
+
+    QTRY_VERIFY(QToolTip::isVisible());
+    QVERIFY(QToolTip::text().contains(QLatin1String("#FF0000")));
+    QCOMPARE(tooltip->builtCount(), builtCount + 1);
+
+    // Past the end of the line, cursorForPosition() gives its last position
+    hover(editorWidget, hoverPoint(editorWidget, 18) + QPoint(40, 0));
+    QTRY_VERIFY(!QToolTip::isVisible());
+
+    // The same expression again, the tooltip is not built again
+    hover(editorWidget, hoverPoint(editorWidget, 10));
+    QTRY_VERIFY(QToolTip::isVisible());
+    QVERIFY(QToolTip::text().contains(QLatin1String("#FF0000")));
+    QCOMPARE(tooltip->builtCount(), builtCount + 1);
+
+    // An expression that wraps is hovered on each of its visual lines
+    const QPlainTextEdit::LineWrapMode wrapMode = editorWidget->lineWrapMode();
+    editorWidget->setLineWrapMode(QPlainTextEdit::WidgetWidth);
+
+    const QString expression = QString::fromLatin1("rgb(0, 0, 255)");
+    QString filler;
+    int start = -1;
+
+    for (int i = 0; i < 400 && start < 0; ++i) {
+        filler += QLatin1String("x ");
+        editorWidget->setPlainText(filler + expression);
+
+        const QTextBlock block = editorWidget->document()->firstBlock();
+        editorWidget->document()->documentLayout()->blockBoundingRect(block);
+
+        const QTextLayout *layout = block.layout();
+
+        if (layout->lineForTextPosition(filler.size()).lineNumber()
+                != layout->lineForTextPosition(filler.size() + expression.size() - 1).lineNumber()) {
+            start = filler.size();
+        }
+    }
+
+    QVERIFY(start >= 0);
+
+    QToolTip::hideText();
+    QTRY_VERIFY(!QToolTip::isVisible());
+
+    hover(editorWidget, hoverPoint(editorWidget, start + 1));
+    QTRY_VERIFY(QToolTip::isVisible());
+    QVERIFY(QToolTip::text().contains(QLatin1String("#0000FF")));
+
+    QToolTip::hideText();
+    QTRY_VERIFY(!QToolTip::isVisible());
+
+    hover(editorWidget, hoverPoint(editorWidget, start + expression.size() - 1));
+    QTRY_VERIFY(QToolTip::isVisible());
+    QVERIFY(QToolTip::text().contains(QLatin1String("#0000FF")));
+
+    QToolTip::hideText();
+
+    watcher->setTooltipsEnabled(d->generalSettings.m_showTooltips);
+    editorWidget->setLineWrapMode(wrapMode);
+
+    file.close();
+}
+
 } // namespace Internal
 } // namespace ColorPicker